@@ -20,6 +20,7 @@
 #include "inx/resources.h"
 
 #include "cubes.h"
+#include "textures_demo.h"
 
 namespace inx
 {
@@ -62,7 +63,17 @@ namespace inx
         }
 
         render_api::init();
+
+        // texture uploads and shader links go to their own thread so this one only draws
+        render_api::start_upload_thread(window);
         Keyboard::init();
+        Jobs::init();
+
+#ifdef NDEBUG
+        // res/ packed with tools/packer (packer res res.pack) is read from the pack instead of file by file. Debug
+        // builds read the loose files, so edits show up without repacking.
+        AssetPack::mount(std::filesystem::path(RES_PATH).concat(".pack"), RES_PATH);
+#endif
 
         // initialize imgui
 
@@ -89,6 +100,9 @@ namespace inx
         PerspectiveCamera camera{glm::vec3(0.f, 0.f, 3.f)};
         OrthographicCamera orth_camera{-ar * zoom, ar * zoom, -zoom, zoom};
 
+        // textures loaded from here on stream their mips in, and share this much video memory
+        Texture::streaming_budget(256 * 1024 * 1024);
+
         init_cubes(manager);
 
         // state for imgui
@@ -96,24 +110,39 @@ namespace inx
         glm::vec3 clear_colour = glm::vec3(.1f, .1f, .1f);
 
         render2d::init(manager);
+        init_textures_demo(manager);
 
         // loop state
         float delta_time = 0.f, last_frame = 0.f;
         bool loop = true;
 
+        Handle<Shader> quad_shader;
+        UniformId quad_vp_matrix, quad_model;
         {
             auto quad_vs = PATH("quad.vs");
             auto quad_fs = PATH("quad.fs");
-            manager.load_resource<Shader>("quad", quad_vs, quad_fs);
+            const u32 slot_count = render2d::texture_slot_count();
+            ShaderDefines quad_defines = { { "MAX_TEXTURE_SLOTS", std::to_string(slot_count) } };
+            quad_shader = manager.load_resource<Shader>("quad", quad_vs, quad_fs, quad_defines);
 
-            auto& shader = manager.get_resource<Shader>("quad");
+            auto& shader = manager.get_resource(quad_shader);
             shader.bind();
-            int samplers[32];
-            for (int i = 0; i < 32; i++)
-                samplers[i] = i;
-            shader.set_ints("u_textures", samplers, 32);
+            // render2d owns the unit layout: its texture slots, then one unit for its texture array
+            std::vector<int> samplers(slot_count);
+            for (u32 i = 0; i < slot_count; i++)
+                samplers[i] = (int)i;
+            shader.set_ints("u_textures", samplers.data(), slot_count);
+            shader.set_int("u_layers", (int)render2d::array_texture_unit());
+
+            quad_vp_matrix = shader.uniform("u_vp_matrix");
+            quad_model = shader.uniform("u_model");
+
+            render2d::register_warm_up(shader);
         }
 
+        // everything is loaded; get the driver's first-draw work out of the way before the first frame
+        render_api::warm_up();
+
         float timer = 0.f;
 
         while (loop)
@@ -185,6 +214,15 @@ namespace inx
                 SDL_SetWindowRelativeMouseMode(window, capture_mouse);
             }
 
+            // finalise resources loaded in the background, then swap in any textures that finished decoding
+            manager.process_loads();
+            Texture::process_uploads();
+
+            // counters cover everything drawn last frame
+            auto uniform_stats = Shader::uniform_stats();
+            Shader::reset_uniform_stats();
+            auto streaming_stats = Texture::streaming_stats();
+
             ImGui_ImplOpenGL3_NewFrame();
             ImGui_ImplSDL3_NewFrame();
             ImGui::NewFrame();
@@ -196,6 +234,14 @@ namespace inx
                 ImGui::ColorEdit3("Clear Colour", (float*)&clear_colour.x);
 
                 ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / io.Framerate, io.Framerate);
+                ImGui::Text("Uniform uploads %u (%u elided)", uniform_stats.uploads, uniform_stats.elided);
+                ImGui::Text("Texture memory %.1f / %.1f MB (%u streamed, %u constrained)",
+                    streaming_stats.texture_bytes / (1024.f * 1024.f), streaming_stats.budget / (1024.f * 1024.f),
+                    streaming_stats.streamed_textures, streaming_stats.constrained_textures);
+
+                auto vt_stats = manager.get_resource(s_TexturesDemo.virtual_texture).stats();
+                ImGui::Text("Virtual texture pages %u / %u resident (%u requested, %u loading)",
+                    vt_stats.resident_pages, vt_stats.cache_pages, vt_stats.requested_pages, vt_stats.pending_loads);
                 ImGui::End();
             }
 
@@ -203,17 +249,18 @@ namespace inx
             render_api::clear();
 
             // draw quad test where we draw a bunch of squares
+            glm::mat4 vp_matrix;
             {
-                auto& shader = manager.get_resource<Shader>("quad");
-                manager.get_resource<Texture>("r2d_white").bind();
+                auto& shader = manager.get_resource(quad_shader);
                 shader.bind();
                 
                 auto proj = glm::perspective(glm::radians(camera.fov()), (float)screen_width / (float)screen_height, .1f, 100.f);
-                shader.set_mat4("u_vp_matrix", proj * camera.view_matrix());
+                vp_matrix = proj * camera.view_matrix();
+                shader.set_mat4(quad_vp_matrix, vp_matrix);
                 
                 auto model = glm::mat4(1.f);
                 model = glm::translate(model, glm::vec3(0.f, 0.f, 0.f));
-                shader.set_mat4("u_model", model);
+                shader.set_mat4(quad_model, model);
                 
                 render2d::begin_batch();
 
@@ -222,9 +269,13 @@ namespace inx
                     for (float x = -10.f; x < 10.f; x += .25f)
                         render2d::draw_quad(glm::vec3(x, y, 0.f), glm::vec2(.2f, .2f), colour);
 
+                draw_textures_demo_sprites(manager);
+
                 render2d::end_batch();
                 render2d::flush();
             }
+
+            draw_textures_demo_virtual(manager, vp_matrix, screen_width, screen_height);
             
             // draw_cubes(manager, camera, screen_width, screen_height, rotate_cubes);
             
@@ -237,6 +288,9 @@ namespace inx
         // cleanup
 
         render2d::shutdown();
+        Jobs::shutdown();
+        AssetPack::unmount_all();
+        render_api::stop_upload_thread();
 
         ImGui_ImplOpenGL3_Shutdown();
         ImGui_ImplSDL3_Shutdown();
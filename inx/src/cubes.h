@@ -22,10 +22,32 @@ static glm::vec3 light_positions[] = {
     glm::vec3( 0.0f,  0.0f, -3.0f)
 };
 
+struct MaterialUniforms
+{
+    UniformId shininess;
+};
+
 struct CubesData
 {
     VAO cube_vao;
     VAO light_cube_vao;
+
+    // shared by every shader that declares the Camera/Lights blocks; written once per frame
+    Ref<UniformBuffer> camera_ubo;
+    Ref<UniformBuffer> lights_ubo;
+
+    // per-draw model matrices; each cube is a memcpy plus a glBindBufferRange
+    Ref<UniformRingBuffer> object_ring;
+
+    std140::Lights lights;
+
+    MaterialUniforms material;
+
+    Handle<Shader> material_shader;
+    Handle<Shader> light_cube_shader;
+    Handle<Texture> container;
+    Handle<Texture> container_spec;
+    Handle<Material> container_material;
 };
 
 static CubesData s_CubesData;
@@ -39,17 +61,30 @@ void init_cubes(ResourceManager &manager)
 
     std::filesystem::path material_shader_vs = PATH("material.vs");
     std::filesystem::path material_shader_fs = PATH("material.fs");
-    manager.load_resource<Shader>("material", material_shader_vs, material_shader_fs);
+    // specialise the material shader to exactly the lights this scene uses
+    ShaderDefines material_defines = {
+        { "NR_POINT_LIGHTS", std::to_string(std::size(light_positions)) },
+        { "USE_DIRECTIONAL_LIGHT", "1" },
+        { "USE_SPOTLIGHT", "1" },
+    };
+    // everything is read and decoded on workers while the buffers below are set up
+    s_CubesData.material_shader = manager.load_resource_async<Shader>("material", material_shader_vs, material_shader_fs, material_defines, ShaderLinkage::Separable);
 
-    std::filesystem::path cube_shader_vs = PATH("light_cube.vs");
+    // the light cubes reuse the material's vertex stage as-is; only their fragment stage gets compiled
     std::filesystem::path cube_shader_fs = PATH("light_cube.fs");
-    manager.load_resource<Shader>("light_cube", cube_shader_vs, cube_shader_fs);
+    s_CubesData.light_cube_shader = manager.load_resource_async<Shader>("light_cube", material_shader_vs, cube_shader_fs, material_defines, ShaderLinkage::Separable);
     
     std::filesystem::path container_path = PATH("container.png");
-    manager.load_resource<Texture>("container", container_path);
+    s_CubesData.container = manager.load_resource_async<Texture>("container", container_path);
 
     std::filesystem::path container_spec_path = PATH("container_spec.png");
-    manager.load_resource<Texture>("container_spec", container_spec_path);
+    s_CubesData.container_spec = manager.load_resource_async<Texture>("container_spec", container_spec_path);
+
+    // finalised after the shader and both textures, whatever order they finish in
+    s_CubesData.container_material = manager.load_resource_async<Material>("container", MaterialSpec{
+        s_CubesData.material_shader,
+        { { "u_material.diffuse", s_CubesData.container }, { "u_material.specular", s_CubesData.container_spec } },
+    });
 
     float vertices[] = {
         // positions          // normals           // texture coords
@@ -108,111 +143,102 @@ void init_cubes(ResourceManager &manager)
 
     s_CubesData.light_cube_vao = VertexArray::create();
     s_CubesData.light_cube_vao->add_vertex_buffer(cube_vbo);
+
+    manager.finish_loads();
+
+    render_api::register_warm_up(manager.get_resource(s_CubesData.material_shader), s_CubesData.cube_vao, BlendMode::None, &manager.get_resource(s_CubesData.container));
+    render_api::register_warm_up(manager.get_resource(s_CubesData.light_cube_shader), s_CubesData.light_cube_vao);
     
-    auto& shader = manager.get_resource<Shader>("material");
-    shader.bind();
-    shader.set_int("u_material.diffuse", 0);
-    shader.set_int("u_material.specular", 1);
+    auto& shader = manager.get_resource(s_CubesData.material_shader);
+
+    // resolve every uniform up front so drawing does no name lookups
+    s_CubesData.material.shininess = shader.uniform("u_material.shininess");
+
+    s_CubesData.camera_ubo = UniformBuffer::create(sizeof(std140::Camera), UniformBlock::Camera);
+    s_CubesData.lights_ubo = UniformBuffer::create(sizeof(std140::Lights), UniformBlock::Lights);
+
+    // room for every cube plus the light cubes; 256 bytes per draw covers the largest common offset alignment
+    u32 draw_count = (u32)cube_positions.size() + 4;
+    s_CubesData.object_ring = UniformRingBuffer::create(draw_count * 256);
+
+    // everything but the spotlight's position/direction is static, so fill it in once here
+    auto& lights = s_CubesData.lights;
+    lights.directional.direction = glm::vec3(-.2f, -1.f, -.3f);
+    lights.directional.ambient = glm::vec3(.05f, .05f, .05f);
+    lights.directional.diffuse = glm::vec3(.4f, .4f, .4f);
+    lights.directional.specular = glm::vec3(.5f, .5f, .5f);
+
+    for (u32 i = 0; i < std140::MAX_POINT_LIGHTS; i++)
+    {
+        auto& pl = lights.point_lights[i];
+        pl.position = light_positions[i];
+        pl.ambient = glm::vec3(.05f, .05f, .05f);
+        pl.diffuse = glm::vec3(.8f, .8f, .8f);
+        pl.specular = glm::vec3(1.f, 1.f, 1.f);
+        pl.constant = 1.f;
+        pl.linear = .09f;
+        pl.quadratic = .032f;
+    }
+
+    lights.spotlight.ambient = glm::vec3(0.f, 0.f, 0.f);
+    lights.spotlight.diffuse = glm::vec3(1.f, 1.f, 1.f);
+    lights.spotlight.specular = glm::vec3(1.f, 1.f, 1.f);
+    lights.spotlight.constant = 1.f;
+    lights.spotlight.linear = .09f;
+    lights.spotlight.quadratic = .032f;
+    lights.spotlight.cutoff = glm::cos(glm::radians(12.5f));
+    lights.spotlight.outer_cutoff = glm::cos(glm::radians(15.f));
 }
 
 void draw_cubes(ResourceManager& manager, PerspectiveCamera& camera, int w, int h, bool rotate_cubes)
 {
-    auto& lighting_shader = manager.get_resource<Shader>("material");
-    lighting_shader.bind();
-    lighting_shader.set_vec3("u_view_position", camera.position());
-    lighting_shader.set_float("u_material.shininess", 32.f);
-
-    // directional light
-    lighting_shader.set_vec3("u_light_direction.direction", glm::vec3(-.2f, -1.f, -.3f));
-    lighting_shader.set_vec3("u_light_direction.ambient", glm::vec3(.05f, .05f, .05f));
-    lighting_shader.set_vec3("u_light_direction.diffuse", glm::vec3(.4f, .4f, .4f));
-    lighting_shader.set_vec3("u_light_direction.specular", glm::vec3(.5f, .5f, .5f));
-
-    // 1st point light
-    lighting_shader.set_vec3("u_point_lights[0].position", light_positions[0]);
-    lighting_shader.set_vec3("u_point_lights[0].ambient", glm::vec3(.05f, .05f, .05f));
-    lighting_shader.set_vec3("u_point_lights[0].diffuse", glm::vec3(.8f, .8f, .8f));
-    lighting_shader.set_vec3("u_point_lights[0].specular", glm::vec3(1.f, 1.f, 1.f));
-    lighting_shader.set_float("u_point_lights[0].constant", 1.f);
-    lighting_shader.set_float("u_point_lights[0].linear", .09f);
-    lighting_shader.set_float("u_point_lights[0].quadratic", .032f);
-
-    // 2nd point light
-    lighting_shader.set_vec3("u_point_lights[1].position", light_positions[1]);
-    lighting_shader.set_vec3("u_point_lights[1].ambient", glm::vec3(.05f, .05f, .05f));
-    lighting_shader.set_vec3("u_point_lights[1].diffuse", glm::vec3(.8f, .8f, .8f));
-    lighting_shader.set_vec3("u_point_lights[1].specular", glm::vec3(1.f, 1.f, 1.f));
-    lighting_shader.set_float("u_point_lights[1].constant", 1.f);
-    lighting_shader.set_float("u_point_lights[1].linear", .09f);
-    lighting_shader.set_float("u_point_lights[1].quadratic", .032f);
-
-    // 3rd point light
-    lighting_shader.set_vec3("u_point_lights[2].position", light_positions[2]);
-    lighting_shader.set_vec3("u_point_lights[2].ambient", glm::vec3(.05f, .05f, .05f));
-    lighting_shader.set_vec3("u_point_lights[2].diffuse", glm::vec3(.8f, .8f, .8f));
-    lighting_shader.set_vec3("u_point_lights[2].specular", glm::vec3(1.f, 1.f, 1.f));
-    lighting_shader.set_float("u_point_lights[2].constant", 1.f);
-    lighting_shader.set_float("u_point_lights[2].linear", .09f);
-    lighting_shader.set_float("u_point_lights[2].quadratic", .032f);
-
-    // 4th point light
-    lighting_shader.set_vec3("u_point_lights[3].position", light_positions[3]);
-    lighting_shader.set_vec3("u_point_lights[3].ambient", glm::vec3(.05f, .05f, .05f));
-    lighting_shader.set_vec3("u_point_lights[3].diffuse", glm::vec3(.8f, .8f, .8f));
-    lighting_shader.set_vec3("u_point_lights[3].specular", glm::vec3(1.f, 1.f, 1.f));
-    lighting_shader.set_float("u_point_lights[3].constant", 1.f);
-    lighting_shader.set_float("u_point_lights[3].linear", .09f);
-    lighting_shader.set_float("u_point_lights[3].quadratic", .032f);
-
-    // 4th point light
-    lighting_shader.set_vec3("u_spotlight.position", camera.position());
-    lighting_shader.set_vec3("u_spotlight.direction", camera.front());
-    lighting_shader.set_vec3("u_spotlight.ambient", glm::vec3(0.f, 0.f, 0.f));
-    lighting_shader.set_vec3("u_spotlight.diffuse", glm::vec3(1.f, 1.f, 1.f));
-    lighting_shader.set_vec3("u_spotlight.specular", glm::vec3(1.f, 1.f, 1.f));
-    lighting_shader.set_float("u_spotlight.constant", 1.f);
-    lighting_shader.set_float("u_spotlight.linear", .09f);
-    lighting_shader.set_float("u_spotlight.quadratic", .032f);
-    lighting_shader.set_float("u_spotlight.cutoff", glm::cos(glm::radians(12.5f)));
-    lighting_shader.set_float("u_spotlight.outer_cutoff", glm::cos(glm::radians(15.f)));
-
-    auto proj = glm::perspective(glm::radians(camera.fov()), (float)(w / h), .1f, 100.f);
-    auto view = camera.view_matrix();
-    lighting_shader.set_mat4("u_projection", proj);
-    lighting_shader.set_mat4("u_view", view);
-
-    glm::mat4 model = glm::mat4(1.f);
-    lighting_shader.set_mat4("u_model", model);
-
-    manager.get_resource<Texture>("container").bind(GL_TEXTURE0);
-    manager.get_resource<Texture>("container_spec").bind(GL_TEXTURE1);
+    const auto& mu = s_CubesData.material;
+    auto& ring = *s_CubesData.object_ring;
+    ring.begin_frame();
+
+    // per-frame shared data: one upload per block regardless of how many shaders read it
+    std140::Camera camera_data;
+    camera_data.projection = glm::perspective(glm::radians(camera.fov()), (float)(w / h), .1f, 100.f);
+    camera_data.view = camera.view_matrix();
+    camera_data.position = camera.position();
+    s_CubesData.camera_ubo->data(camera_data);
+
+    s_CubesData.lights.spotlight.position = camera.position();
+    s_CubesData.lights.spotlight.direction = camera.front();
+    s_CubesData.lights_ubo->data(s_CubesData.lights);
+
+    auto& material = manager.get_resource(s_CubesData.container_material);
+    material.bind();
+    material.shader().set_float(mu.shininess, 32.f);
+
+    std140::Object object;
 
     s_CubesData.cube_vao->bind();
     for (unsigned int i = 0; i < cube_positions.size(); i++)
     {
         float angle = rotate_cubes ? (20.f * i) + (SDL_GetTicks() / 10.f) : 0;
 
-        model = glm::mat4(1.f);
-        model = glm::translate(model, cube_positions[i]);
-        model = glm::rotate(model, glm::radians(angle), glm::vec3(1.f, .3f, .5f));
-        lighting_shader.set_mat4("u_model", model);
+        object.model = glm::mat4(1.f);
+        object.model = glm::translate(object.model, cube_positions[i]);
+        object.model = glm::rotate(object.model, glm::radians(angle), glm::vec3(1.f, .3f, .5f));
+        ring.push(UniformBlock::Object, object);
 
         glDrawArrays(GL_TRIANGLES, 0, 36);
     }
 
-    auto& cube_shader = manager.get_resource<Shader>("light_cube");
+    auto& cube_shader = manager.get_resource(s_CubesData.light_cube_shader);
     cube_shader.bind();
-    cube_shader.set_mat4("u_projection", proj);
-    cube_shader.set_mat4("u_view", view);
 
     s_CubesData.light_cube_vao->bind();
     for (unsigned int i = 0; i < 4; i++)
     {
-        model = glm::mat4(1.f);
-        model = glm::translate(model, light_positions[i]);
-        model = glm::scale(model, glm::vec3(.2f));
-        cube_shader.set_mat4("u_model", model);
+        object.model = glm::mat4(1.f);
+        object.model = glm::translate(object.model, light_positions[i]);
+        object.model = glm::scale(object.model, glm::vec3(.2f));
+        ring.push(UniformBlock::Object, object);
 
         glDrawArrays(GL_TRIANGLES, 0, 36);
     }
+
+    ring.end_frame();
 }
\ No newline at end of file
@@ -2,13 +2,107 @@
 #define __INX_CORE_H__
 
 #include <array>
+#include <filesystem>
+#include <functional>
+#include <span>
 
 #include <glm/glm.hpp>
 
+#include "types.h"
+
 namespace inx
 {
     enum Key;
 
+    /// @brief Fixed pool of worker threads for CPU work that shouldn't stall the frame, like decoding files.
+    struct Jobs
+    {
+    public:
+        /// @param thread_count number of workers; 0 uses one less than the number of hardware threads
+        static void init(u32 thread_count = 0);
+
+        /// @brief Finish every queued job and join the workers
+        static void shutdown();
+
+        /// @brief Queue a job to run on any worker. Jobs must not touch the GL context. Before init() (or after
+        /// shutdown()) the job runs immediately on the calling thread.
+        static void submit(std::function<void()> job);
+
+        static u32 thread_count();
+    };
+
+    /// @brief Read-only memory mapping of a whole file. Pages are read in by the OS as they're touched, so nothing is
+    /// copied up front and the mapping can be read from any thread.
+    struct MappedFile
+    {
+    public:
+        MappedFile() = default;
+
+        /// @brief Map `filepath`; check is_open() for failure (an empty file can't be mapped either)
+        MappedFile(const std::filesystem::path& filepath);
+        ~MappedFile();
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool is_open() const { return _data != nullptr; }
+
+        const u8* data() const { return _data; }
+        size_t size() const { return _size; }
+
+    private:
+        void _close();
+
+        const u8* _data = nullptr;
+        size_t _size = 0;
+
+#ifdef _WIN32
+        /// @brief file and file mapping HANDLEs
+        void* _file = nullptr;
+        void* _mapping = nullptr;
+#endif
+    };
+
+    /// @brief The contents of one asset file, read without copying: a span into a mounted pack, or else the loose file
+    /// mapped on its own. Either way the mapping is kept alive for as long as this is.
+    struct AssetFile
+    {
+    public:
+        Ref<MappedFile> mapping;
+        std::span<const u8> bytes;
+
+        /// @brief 64-bit FNV-1a of the contents when a pack recorded it; 0 for loose files, which nothing has hashed
+        u64 content_hash = 0;
+
+        bool is_open() const { return mapping != nullptr; }
+
+        const u8* data() const { return bytes.data(); }
+        size_t size() const { return bytes.size(); }
+    };
+
+    /// @brief Archives of asset files built by tools/packer, mapped whole so a cold start pays for one file open rather
+    /// than one per asset. Once mounted, a pack stands in for the directory it was built from: every loader reads
+    /// through open(), which serves files under that directory out of the pack and anything else from disk.
+    struct AssetPack
+    {
+    public:
+        /// @brief Map the pack at `pack_filepath`, built from the directory `root`. Packs mounted later take priority.
+        /// False if the pack is missing or malformed, in which case loads keep going to the loose files. A mounted pack
+        /// wins over loose files even when they were edited after it was built, so the demo mounts its pack in
+        /// release builds only and debug builds see edits without repacking.
+        static bool mount(const std::filesystem::path& pack_filepath, const std::filesystem::path& root);
+
+        /// @brief Unmount every pack. Files already opened from one stay valid.
+        static void unmount_all();
+
+        /// @brief Open `filepath` from a mounted pack if one has it, otherwise from disk; safe from any thread. Check
+        /// is_open() for failure; an empty file is open with no bytes.
+        static AssetFile open(const std::filesystem::path& filepath);
+    };
+
     /// @brief Stores all state concerning the keyboard. Essentially functions as a wrapper around SDL scancodes.
     struct Keyboard
     {
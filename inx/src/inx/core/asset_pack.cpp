@@ -0,0 +1,152 @@
+#include "../core.h"
+#include "pack_format.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace inx
+{
+    struct MountedPack
+    {
+        Ref<MappedFile> file;
+
+        /// @brief absolute and normalised, to match opened paths against
+        std::filesystem::path root;
+
+        /// @brief copied out of the mapping at mount, sorted by name hash
+        std::vector<PackEntry> entries;
+    };
+
+    struct AssetPackState
+    {
+        /// @brief in mount order; searched newest first
+        std::vector<Ref<MountedPack>> packs;
+        std::mutex mutex;
+    };
+
+    static AssetPackState PACK_STATE;
+
+    static std::filesystem::path _normalise(const std::filesystem::path& path)
+    {
+        return std::filesystem::absolute(path).lexically_normal();
+    }
+
+    bool AssetPack::mount(const std::filesystem::path& pack_filepath, const std::filesystem::path& root)
+    {
+        auto file = create_ref<MappedFile>(pack_filepath);
+        if (!file->is_open()) return false;
+
+        PackHeader header;
+        if (file->size() < sizeof(header)) return false;
+        std::memcpy(&header, file->data(), sizeof(header));
+
+        if (std::memcmp(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0 || header.version != PACK_VERSION)
+        {
+            std::cerr << "Not an asset pack (or one from another version): " << pack_filepath.string() << "\n";
+            return false;
+        }
+
+        const u64 file_size = file->size();
+        if (header.toc_offset > file_size || header.entry_count > (file_size - header.toc_offset) / sizeof(PackEntry))
+        {
+            std::cerr << "Asset pack table of contents is truncated: " << pack_filepath.string() << "\n";
+            return false;
+        }
+
+        auto pack = create_ref<MountedPack>();
+        pack->file = file;
+        pack->root = _normalise(root);
+        pack->entries.resize(header.entry_count);
+        std::memcpy(pack->entries.data(), file->data() + header.toc_offset, header.entry_count * sizeof(PackEntry));
+
+        for (const auto& entry : pack->entries)
+        {
+            if (entry.offset > file_size || entry.size > file_size - entry.offset || (u64)entry.name_offset + entry.name_size > file_size)
+            {
+                std::cerr << "Asset pack entry out of bounds: " << pack_filepath.string() << "\n";
+                return false;
+            }
+        }
+
+        // lookups binary search by hash; the packer writes them sorted, but nothing else relies on it
+        auto by_hash = [](const PackEntry& a, const PackEntry& b) { return a.name_hash < b.name_hash; };
+        if (!std::is_sorted(pack->entries.begin(), pack->entries.end(), by_hash))
+            std::sort(pack->entries.begin(), pack->entries.end(), by_hash);
+
+        std::lock_guard lock(PACK_STATE.mutex);
+        PACK_STATE.packs.push_back(pack);
+        return true;
+    }
+
+    void AssetPack::unmount_all()
+    {
+        std::lock_guard lock(PACK_STATE.mutex);
+        PACK_STATE.packs.clear();
+    }
+
+    AssetFile AssetPack::open(const std::filesystem::path& filepath)
+    {
+        AssetFile result;
+
+        {
+            std::lock_guard lock(PACK_STATE.mutex);
+
+            const auto path = PACK_STATE.packs.empty() ? std::filesystem::path() : _normalise(filepath);
+            for (auto it = PACK_STATE.packs.rbegin(); it != PACK_STATE.packs.rend(); it++)
+            {
+                const auto& pack = **it;
+
+                auto relative = path.lexically_relative(pack.root);
+                if (relative.empty() || *relative.begin() == "..") continue;
+
+                const std::string name = relative.generic_string();
+                const u64 hash = hash_fnv1a64(name);
+
+                auto entry = std::lower_bound(pack.entries.begin(), pack.entries.end(), hash,
+                    [](const PackEntry& e, u64 h) { return e.name_hash < h; });
+                if (entry == pack.entries.end() || entry->name_hash != hash) continue;
+
+                // the packer refuses colliding names, but a file that was never packed could still share a hash
+                std::string_view stored((const char*)pack.file->data() + entry->name_offset, entry->name_size);
+                if (stored != name) continue;
+
+                result.mapping = pack.file;
+                result.bytes = { pack.file->data() + entry->offset, (size_t)entry->size };
+                result.content_hash = entry->checksum;
+                break;
+            }
+        }
+
+        if (result.is_open())
+        {
+#ifndef NDEBUG
+            if (hash_fnv1a64(std::string_view((const char*)result.data(), result.size())) != result.content_hash)
+            { // checked outside the lock, so debug builds don't serialise every worker's reads on it
+                std::cerr << "Corrupt file in asset pack: " << filepath.string() << "\n";
+                throw std::runtime_error("Corrupt file in asset pack: " + filepath.string());
+            }
+#endif
+
+            return result;
+        }
+
+        auto file = create_ref<MappedFile>(filepath);
+        if (file->is_open())
+        {
+            result.bytes = { file->data(), file->size() };
+            result.mapping = std::move(file);
+        }
+        else
+        { // an empty file can't be mapped, but it opened fine; an unmapped MappedFile stands in for it
+            std::error_code error;
+            if (std::filesystem::is_regular_file(filepath, error) && std::filesystem::file_size(filepath, error) == 0 && !error)
+                result.mapping = std::move(file);
+        }
+
+        return result;
+    }
+} // namespace inx
@@ -0,0 +1,99 @@
+#include "../core.h"
+#include "../types.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace inx
+{
+    struct JobState
+    {
+        std::vector<std::thread> workers;
+        std::deque<std::function<void()>> queue;
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        bool running = false;
+    };
+
+    static JobState JOB_STATE;
+
+    static void _worker()
+    {
+        auto& js = JOB_STATE;
+
+        for (;;)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock lock(js.mutex);
+                js.wake.wait(lock, [&js]() { return !js.running || !js.queue.empty(); });
+
+                // only stop once the queue has drained so nothing submitted before shutdown is lost
+                if (js.queue.empty()) return;
+
+                job = std::move(js.queue.front());
+                js.queue.pop_front();
+            }
+
+            job();
+        }
+    }
+
+    void Jobs::init(u32 thread_count)
+    {
+        auto& js = JOB_STATE;
+
+        if (js.running) return;
+
+        if (thread_count == 0)
+            thread_count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+        js.running = true;
+        js.workers.reserve(thread_count);
+        for (u32 i = 0; i < thread_count; i++)
+            js.workers.emplace_back(_worker);
+    }
+
+    void Jobs::shutdown()
+    {
+        auto& js = JOB_STATE;
+
+        {
+            std::lock_guard lock(js.mutex);
+            if (!js.running) return;
+            js.running = false;
+        }
+        js.wake.notify_all();
+
+        for (auto& worker : js.workers)
+            worker.join();
+        js.workers.clear();
+    }
+
+    void Jobs::submit(std::function<void()> job)
+    {
+        auto& js = JOB_STATE;
+
+        {
+            std::lock_guard lock(js.mutex);
+            if (js.running)
+            {
+                js.queue.push_back(std::move(job));
+                js.wake.notify_one();
+                return;
+            }
+        }
+
+        job();
+    }
+
+    u32 Jobs::thread_count()
+    {
+        return (u32)JOB_STATE.workers.size();
+    }
+} // namespace inx
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "../core.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace inx
+{
+#ifdef _WIN32
+    MappedFile::MappedFile(const std::filesystem::path& filepath)
+    {
+        HANDLE file = CreateFileW(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+        {
+            CloseHandle(file);
+            return;
+        }
+
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping)
+        {
+            CloseHandle(file);
+            return;
+        }
+
+        void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!data)
+        {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return;
+        }
+
+        _file = file;
+        _mapping = mapping;
+        _data = (const u8*)data;
+        _size = (size_t)size.QuadPart;
+    }
+
+    void MappedFile::_close()
+    {
+        if (_data) UnmapViewOfFile(_data);
+        if (_mapping) CloseHandle(_mapping);
+        if (_file) CloseHandle(_file);
+
+        _data = nullptr;
+        _size = 0;
+        _mapping = nullptr;
+        _file = nullptr;
+    }
+#else
+    MappedFile::MappedFile(const std::filesystem::path& filepath)
+    {
+        int fd = open(filepath.c_str(), O_RDONLY);
+        if (fd < 0) return;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0)
+        {
+            close(fd);
+            return;
+        }
+
+        void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        // the mapping keeps its own reference to the file
+        close(fd);
+        if (data == MAP_FAILED) return;
+
+        _data = (const u8*)data;
+        _size = (size_t)info.st_size;
+    }
+
+    void MappedFile::_close()
+    {
+        if (_data) munmap((void*)_data, _size);
+
+        _data = nullptr;
+        _size = 0;
+    }
+#endif
+
+    MappedFile::~MappedFile()
+    {
+        _close();
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this == &other) return *this;
+
+        _close();
+
+        std::swap(_data, other._data);
+        std::swap(_size, other._size);
+#ifdef _WIN32
+        std::swap(_file, other._file);
+        std::swap(_mapping, other._mapping);
+#endif
+
+        return *this;
+    }
+} // namespace inx
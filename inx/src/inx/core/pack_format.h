@@ -0,0 +1,60 @@
+#ifndef __INX_PACK_FORMAT_H__
+#define __INX_PACK_FORMAT_H__
+
+#include "../types.h"
+
+// On disk layout of an asset pack, shared by AssetPack and the packer tool. Everything is little endian:
+//
+//  PackHeader
+//  PackEntry[entry_count]  at toc_offset, sorted by name_hash
+//  names                   at names_offset, each entry's name back to back without terminators
+//  file contents           each starting on a PACK_ALIGNMENT boundary
+//
+// The table of contents also starts on a PACK_ALIGNMENT boundary, so the header can grow without moving anything
+// else around.
+
+namespace inx
+{
+    static constexpr u8 PACK_MAGIC[4] = { 'I', 'N', 'X', 'P' };
+    static constexpr u32 PACK_VERSION = 1;
+
+    /// @brief file contents are placed on cache line boundaries, so loaders can read them straight out of the mapping
+    /// with aligned loads
+    static constexpr u32 PACK_ALIGNMENT = 64;
+
+    struct PackHeader
+    {
+        u8 magic[4];
+        u32 version;
+        u32 entry_count;
+        u32 alignment;
+        u64 toc_offset;
+        u64 names_offset;
+    };
+
+    struct PackEntry
+    {
+        /// @brief hash_fnv1a64 of the file's path relative to the packed directory, '/' separated
+        u64 name_hash;
+
+        u64 offset;
+        u64 size;
+
+        /// @brief hash_fnv1a64 of the contents; loaders that key caches on the contents can use it as is
+        u64 checksum;
+
+        /// @brief where the path is in the name table
+        u32 name_offset;
+        u32 name_size;
+    };
+
+    static_assert(sizeof(PackHeader) == 32);
+    static_assert(sizeof(PackEntry) == 40);
+
+    constexpr u64 pack_align(u64 offset)
+    {
+        return (offset + PACK_ALIGNMENT - 1) & ~(u64)(PACK_ALIGNMENT - 1);
+    }
+} // namespace inx
+
+#endif // __INX_PACK_FORMAT_H__
@@ -5,6 +5,11 @@
 #include "../renderer/renderer_internal.h"
 #include "../resources.h"
 
+#include <array>
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+
 namespace inx
 {
     struct OpenGLRenderAPI : public RenderAPI
@@ -16,6 +21,56 @@ namespace inx
 
         virtual void clear_colour(const glm::vec3& colour) const override;
         virtual void clear() const override;
+
+        virtual void blend(BlendMode mode) const override;
+
+        virtual u32 max_texture_units() const override;
+
+        virtual void warm_up(const std::vector<WarmUpEntry>& entries) const override;
+
+        virtual bool start_upload_thread(SDL_Window* window) const override;
+        virtual void stop_upload_thread() const override;
+    };
+
+    /// @brief Completion of one job on the upload thread. The job's GL work is visible to the render context once
+    /// complete() returns true; only call complete() and wait() from the render thread.
+    struct UploadTicket
+    {
+    public:
+        /// @brief non-blocking check
+        bool complete();
+
+        /// @brief block until the job has run and its GL work has finished
+        void wait();
+
+    private:
+        friend struct OpenGLUploadThread;
+
+        /// @brief set by the upload thread once the job has run and `_fence` is placed
+        std::atomic<bool> _submitted = false;
+        void* _fence = nullptr;
+
+        bool _complete = false;
+    };
+
+    /// @brief Optional thread owning a second GL context that shares objects with the main one. Resource creation and
+    /// uploads run there instead of on the render thread, with each job published back through a fence.
+    struct OpenGLUploadThread
+    {
+    public:
+        /// @brief create the shared context and start the thread; must be called on the render thread while its
+        /// context is current
+        static bool start(SDL_Window* window);
+        static void stop();
+
+        static bool running();
+
+        /// @brief Queue GL work for the upload context. The job may only use objects that are shared between
+        /// contexts (textures, buffers, shaders, programs, syncs), never VAOs or framebuffers.
+        static Ref<UploadTicket> submit(std::function<void()> job);
+
+    private:
+        static void _run();
     };
 
     struct OpenGLVertexBuffer : public VertexBuffer
@@ -55,6 +110,50 @@ namespace inx
         u32 _count;
     };
 
+    struct OpenGLUniformBuffer : public UniformBuffer
+    {
+    public:
+        OpenGLUniformBuffer(u32 size, u32 binding);
+        virtual ~OpenGLUniformBuffer();
+
+        virtual void bind() const override;
+
+        virtual void data(const void* data, u32 size, u32 offset = 0) override;
+
+    private:
+        u32 _id;
+        u32 _binding;
+    };
+
+    struct OpenGLUniformRingBuffer : public UniformRingBuffer
+    {
+    public:
+        static constexpr u32 FRAMES_IN_FLIGHT = 3;
+
+        OpenGLUniformRingBuffer(u32 frame_size);
+        virtual ~OpenGLUniformRingBuffer();
+
+        virtual void begin_frame() override;
+        virtual void end_frame() override;
+
+        virtual void push(UniformBlock binding, const void* data, u32 size) override;
+
+    private:
+        u32 _id;
+        u32 _frame_size;
+        u32 _alignment;
+
+        /// @brief persistently mapped pointer to the whole ring; null when buffer storage is unavailable
+        u8* _mapped = nullptr;
+
+        u32 _frame = 0;
+        u32 _offset = 0;
+        u32 _end = 0;
+
+        /// @brief GLsync for each region; opaque here to avoid pulling glad into this header
+        void* _fences[FRAMES_IN_FLIGHT] = {};
+    };
+
     struct OpenGLVertexArray : public VertexArray
     {
     public:
@@ -75,37 +174,247 @@ namespace inx
         Ref<IndexBuffer> _index_buffer;
     };
 
+    /// @brief One preprocessed stage of a program
+    struct ShaderSource
+    {
+        u32 stage;
+        std::string code;
+    };
+
+    /// @brief A GL program plus everything reflected from it. Programs are shared between every OpenGLShader built from
+    /// identical preprocessed sources, so each shader variant is only compiled once.
+    struct OpenGLProgram
+    {
+    public:
+        /// @param key Hash of the preprocessed sources; identifies the variant in memory and in the binary cache
+        /// @param separable Link as a separable program for use in a program pipeline
+        OpenGLProgram(const std::vector<ShaderSource>& sources, u64 key, bool separable = false);
+
+        /// @brief Get the live program for these sources, creating it only if no shader is using it yet
+        static Ref<OpenGLProgram> acquire(const std::vector<ShaderSource>& sources, u64 key, bool separable = false);
+        ~OpenGLProgram();
+
+        u32 id() const { return _id; }
+
+        bool is_ready() const;
+
+        /// @brief Finish a pending link if there is one; blocks until the driver is done
+        void ensure_ready() const;
+
+        UniformId uniform(std::string_view name) const;
+
+        /// @brief Same as uniform(), but a missing uniform is expected and not reported
+        UniformId find_uniform(std::string_view name) const;
+
+        void set_int(UniformId id, int i) const;
+        void set_ints(UniformId id, int* ints, u32 count) const;
+        void set_float(UniformId id, float f) const;
+        void set_vec3(UniformId id, const glm::vec3& vec) const;
+        void set_mat4(UniformId id, const glm::mat4& mat) const;
+
+        static UniformStats uniform_stats();
+        static void reset_uniform_stats();
+
+    private:
+        struct UniformInfo
+        {
+            std::string name;
+            i32 location;
+            u32 type;
+            i32 count;
+
+            /// @brief byte offset of this uniform's value in _shadow
+            u32 shadow_offset;
+        };
+
+        /// @brief state of a compile/link that has been issued but not yet checked
+        struct PendingLink
+        {
+            std::vector<u32> shader_ids;
+            bool save_binary = false;
+            std::filesystem::path cache_path;
+
+            /// @brief set when the compile and link were handed to the upload thread
+            Ref<UploadTicket> ticket;
+        };
+
+        u32 _id;
+
+        bool _ready = false;
+        PendingLink _pending;
+
+        /// @brief every active uniform, reflected from the program after linking
+        std::vector<UniformInfo> _uniforms;
+
+        /// @brief maps the hash of a uniform name to its index in _uniforms
+        std::unordered_map<u32, u32> _uniform_lookup;
+
+        /// @brief CPU copy of every uniform value last uploaded; sets that match it skip the GL call
+        mutable std::vector<u8> _shadow;
+
+    private:
+        void finish_link();
+
+        void reflect_uniforms();
+        void bind_uniform_blocks();
+        void add_uniform(const std::string& name, i32 location, u32 type, i32 count, u32 shadow_offset);
+        void read_shadow(i32 location, u32 type, u32 shadow_offset);
+
+        /// @brief Compare a new value against the shadow copy and record it
+        /// @return True if the value changed and needs uploading
+        bool update_shadow(UniformId id, const void* data, u32 size) const;
+    };
+
     struct OpenGLShader : public Shader
     {
     public:
-        OpenGLShader(const std::filesystem::path& vertex_filepath, const std::filesystem::path& fragment_filepath);
-        ~OpenGLShader();
+        OpenGLShader(const std::filesystem::path& vertex_filepath, const std::filesystem::path& fragment_filepath, const ShaderDefines& defines);
+
+        /// @brief from already preprocessed sources
+        OpenGLShader(std::string vertex_code, std::string fragment_code);
 
         virtual void bind() const override;
 
-        virtual void set_int(const std::string& name, int i) const override;
-        virtual void set_ints(const std::string& name, int* ints, u32 count) const override;
-        virtual void set_float(const std::string& name, float f) const override;
-        virtual void set_vec3(const std::string& name, const glm::vec3& vec) const override;
-        virtual void set_mat4(const std::string& name, const glm::mat4& mat) const override;
+        virtual bool is_ready() const override { return _program->is_ready(); }
+
+        virtual UniformId uniform(std::string_view name) const override { return _program->uniform(name); }
+
+        virtual void set_int(UniformId id, int i) const override { _program->set_int(id, i); }
+        virtual void set_ints(UniformId id, int* ints, u32 count) const override { _program->set_ints(id, ints, count); }
+        virtual void set_float(UniformId id, float f) const override { _program->set_float(id, f); }
+        virtual void set_vec3(UniformId id, const glm::vec3& vec) const override { _program->set_vec3(id, vec); }
+        virtual void set_mat4(UniformId id, const glm::mat4& mat) const override { _program->set_mat4(id, mat); }
+
+        virtual void set_int(std::string_view name, int i) const override { set_int(uniform(name), i); }
+        virtual void set_ints(std::string_view name, int* ints, u32 count) const override { set_ints(uniform(name), ints, count); }
+        virtual void set_float(std::string_view name, float f) const override { set_float(uniform(name), f); }
+        virtual void set_vec3(std::string_view name, const glm::vec3& vec) const override { set_vec3(uniform(name), vec); }
+        virtual void set_mat4(std::string_view name, const glm::mat4& mat) const override { set_mat4(uniform(name), mat); }
 
     private:
+        Ref<OpenGLProgram> _program;
+    };
+
+    /// @brief A shader built from separable single-stage programs bound together in a program pipeline. Uniform setters
+    /// write to whichever stages declare the uniform.
+    struct OpenGLPipelineShader : public Shader
+    {
+    public:
+        OpenGLPipelineShader(const std::filesystem::path& vertex_filepath, const std::filesystem::path& fragment_filepath, const ShaderDefines& defines);
+
+        /// @brief from already preprocessed sources
+        OpenGLPipelineShader(std::string vertex_code, std::string fragment_code);
+        ~OpenGLPipelineShader();
+
+        virtual void bind() const override;
+
+        virtual bool is_ready() const override;
+
+        virtual UniformId uniform(std::string_view name) const override;
+
+        virtual void set_int(UniformId id, int i) const override;
+        virtual void set_ints(UniformId id, int* ints, u32 count) const override;
+        virtual void set_float(UniformId id, float f) const override;
+        virtual void set_vec3(UniformId id, const glm::vec3& vec) const override;
+        virtual void set_mat4(UniformId id, const glm::mat4& mat) const override;
+
+        virtual void set_int(std::string_view name, int i) const override { set_int(uniform(name), i); }
+        virtual void set_ints(std::string_view name, int* ints, u32 count) const override { set_ints(uniform(name), ints, count); }
+        virtual void set_float(std::string_view name, float f) const override { set_float(uniform(name), f); }
+        virtual void set_vec3(std::string_view name, const glm::vec3& vec) const override { set_vec3(uniform(name), vec); }
+        virtual void set_mat4(std::string_view name, const glm::mat4& mat) const override { set_mat4(uniform(name), mat); }
+
+    private:
+        static constexpr u32 STAGE_COUNT = 2;
+
         u32 _id;
+        mutable bool _stages_attached = false;
+
+        std::array<Ref<OpenGLProgram>, STAGE_COUNT> _stages;
+
+        struct PipelineUniform
+        {
+            std::string name;
+            std::array<UniformId, STAGE_COUNT> ids;
+        };
+
+        /// @brief per stage handle for each uniform resolved so far; UniformId::index points in here
+        mutable std::vector<PipelineUniform> _uniforms;
+
+        /// @brief maps the hash of a uniform name to its index in _uniforms
+        mutable std::unordered_map<u32, u32> _uniform_lookup;
+
+    private:
+        template<typename F>
+        void for_each_stage(UniformId id, F&& set) const;
     };
 
+    /// @brief Read a shader file, resolving #include "file" directives (relative to the including file, each file at
+    /// most once) and injecting one #define per entry in defines straight after the #version line
+    std::string preprocess_shader(const std::filesystem::path& filepath, const ShaderDefines& defines);
+
+    /// @brief One GL sampler object per distinct Sampler, created on first use and shared by every texture
+    struct OpenGLSamplerCache
+    {
+    public:
+        /// @brief bind the sampler object matching `sampler` to texture unit `slot` (GL_TEXTURE0 + n)
+        static void bind(unsigned int slot, const Sampler& sampler);
+
+        /// @brief number of sampler objects created so far
+        static u32 count();
+
+    private:
+        static u32 _get(const Sampler& sampler);
+    };
+
+    struct TextureLoad;
+    struct TextureStream;
+    struct Image;
+
     struct OpenGLTexture : public Texture
     {
     public:
         OpenGLTexture(const std::filesystem::path& texture_filepath);
+
+        /// @brief from an image already decoded (or null to decode it here, as above)
+        OpenGLTexture(const std::filesystem::path& texture_filepath, Ref<Image> image);
         OpenGLTexture(const TextureSpec& spec);
+        ~OpenGLTexture();
 
         void bind(unsigned int slot = 0) const override;
+        virtual void bind(unsigned int slot, const Sampler& sampler) const override;
+
+        virtual void sampler(const Sampler& sampler) override { _spec.sampler = sampler; }
+
+        virtual void request_size(u32 pixels) const override;
+
+        virtual bool is_ready() const override { return !_load; }
 
         virtual const TextureSpec& spec() const override { return _spec; }
 
         virtual void data(const void* data, u32 size) override;
 
+        /// @brief Copy finished decodes into the staging ring and fill their textures from it, then move streamed
+        /// textures' resident mips toward what they're wanted at
+        static void process_uploads(size_t byte_budget);
+
+        static void streaming_budget(size_t bytes);
+        static TextureStreamingStats streaming_stats();
+
     private:
+        /// @brief returns false if no staging buffer is free yet
+        static bool _upload(TextureLoad& load);
+
+        /// @brief hand the upload to the upload thread, which fills a fresh texture to swap in once its ticket completes
+        static void _submit_upload(const Ref<TextureLoad>& load);
+        void _swap_in(TextureLoad& load);
+
+        void _image_info(const Image& image);
+
+        /// @brief replace the placeholder with a mutable texture holding only the image's smallest mips
+        void _stream_in(TextureLoad& load);
+        static void _update_streaming(size_t byte_budget);
+
         u32 _id;
         int _width;
         int _height;
@@ -113,6 +422,129 @@ namespace inx
         TextureSpec _spec;
 
         u32 _format;
+
+        /// @brief in-flight decode; null once the image has been uploaded
+        Ref<TextureLoad> _load;
+
+        /// @brief CPU mip chain and residency; null unless the texture is streamed
+        Scope<TextureStream> _stream;
+
+        /// @brief estimated VRAM use, counted in the streaming stats
+        size_t _bytes = 0;
+    };
+
+    struct OpenGLTexture2DArray : public Texture2DArray
+    {
+    public:
+        OpenGLTexture2DArray(const TextureArraySpec& spec);
+        ~OpenGLTexture2DArray();
+
+        virtual void bind(unsigned int slot = 0) const override;
+        virtual void bind(unsigned int slot, const Sampler& sampler) const override;
+
+        virtual void sampler(const Sampler& sampler) override { _spec.sampler = sampler; }
+
+        virtual const TextureArraySpec& spec() const override { return _spec; }
+
+        virtual void data(u32 layer, const void* data, u32 size, u32 level = 0) override;
+        virtual void generate_mipmaps() override;
+
+    private:
+        u32 _id;
+
+        TextureArraySpec _spec;
+
+        u32 _format;
+
+        size_t _bytes = 0;
+    };
+
+    struct VirtualTextureSource;
+    struct VirtualPageLoad;
+
+    struct OpenGLVirtualTexture : public VirtualTexture
+    {
+    public:
+        OpenGLVirtualTexture(const std::filesystem::path& image_filepath, const VirtualTextureSpec& spec);
+        ~OpenGLVirtualTexture();
+
+        virtual void bind(const Shader& shader, unsigned int cache_slot, unsigned int indirection_slot) const override;
+
+        virtual void begin_feedback(i32 screen_width, i32 screen_height) override;
+        virtual void end_feedback() override;
+
+        virtual void update() override;
+
+        virtual bool is_ready() const override { return _cache_id != 0; }
+        virtual VirtualTextureStats stats() const override;
+
+    private:
+        constexpr static const u32 READBACK_COUNT = 3;
+        constexpr static const u32 NO_PAGE = 0xffffffff;
+
+        struct Readback
+        {
+            u32 buffer = 0;
+            size_t size = 0;
+            void* fence = nullptr;
+
+            i32 width = 0;
+            i32 height = 0;
+        };
+
+        struct CachePage
+        {
+            u32 key = NO_PAGE;
+            u64 last_used = 0;
+        };
+
+        /// @brief create the GPU side once the image has been decoded, with the single coarsest page resident
+        void _create();
+
+        void _read_feedback(Readback& readback);
+
+        /// @brief copy a cut page into the cache, evicting the least recently needed page if it's full
+        void _place(u32 key, const std::vector<u8>& pixels);
+
+        void _write_page_table();
+
+        VirtualTextureSpec _spec;
+        Ref<VirtualTextureSource> _source;
+
+        /// @brief pages across at mip 0, and mips down to the single page that covers everything
+        u32 _pages = 0;
+        u32 _mips = 0;
+
+        u32 _cache_id = 0;
+        u32 _indirection_id = 0;
+
+        u32 _feedback_fbo = 0;
+        u32 _feedback_colour = 0;
+        u32 _feedback_depth = 0;
+        i32 _feedback_width = 0;
+        i32 _feedback_height = 0;
+        i32 _screen_width = 0;
+        i32 _screen_height = 0;
+        bool _in_feedback = false;
+
+        std::array<Readback, READBACK_COUNT> _readbacks;
+        u32 _next_readback = 0;
+
+        std::vector<CachePage> _cache;
+        std::unordered_map<u32, u32> _resident;
+        std::unordered_map<u32, Ref<VirtualPageLoad>> _loading;
+
+        /// @brief missing pages from the latest feedback, coarsest last so they're loaded first
+        std::vector<u32> _wanted;
+
+        /// @brief CPU copy of each indirection level, rebuilt whenever residency changes
+        std::vector<std::vector<u8>> _page_table;
+        bool _page_table_dirty = false;
+
+        u64 _frame = 0;
+        u32 _requested_pages = 0;
+        u64 _dropped_loads = 0;
+        u64 _evictions = 0;
     };
 } // namespace inx
 
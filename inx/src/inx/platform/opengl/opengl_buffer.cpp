@@ -1,4 +1,8 @@
 #include "../opengl.h"
+#include "opengl_extensions.h"
+
+#include <cstring>
+#include <iostream>
 
 #include <glad/glad.h>
 
@@ -61,4 +65,114 @@ namespace inx
     {
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     }
+
+    OpenGLUniformBuffer::OpenGLUniformBuffer(u32 size, u32 binding)
+        : _binding(binding)
+    {
+        glGenBuffers(1, &_id);
+        glBindBuffer(GL_UNIFORM_BUFFER, _id);
+        glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, _binding, _id);
+    }
+
+    OpenGLUniformBuffer::~OpenGLUniformBuffer()
+    {
+        glDeleteBuffers(1, &_id);
+    }
+
+    void OpenGLUniformBuffer::bind() const
+    {
+        glBindBufferBase(GL_UNIFORM_BUFFER, _binding, _id);
+    }
+
+    void OpenGLUniformBuffer::data(const void* data, u32 size, u32 offset)
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, _id);
+        glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+    }
+
+    OpenGLUniformRingBuffer::OpenGLUniformRingBuffer(u32 frame_size)
+    {
+        GLint alignment;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        _alignment = (u32)alignment;
+
+        // keep every region aligned so each frame's first push starts on a valid offset
+        _frame_size = (frame_size + _alignment - 1) / _alignment * _alignment;
+        u32 total_size = _frame_size * FRAMES_IN_FLIGHT;
+
+        glGenBuffers(1, &_id);
+        glBindBuffer(GL_UNIFORM_BUFFER, _id);
+
+        if (OPENGL_EXTENSIONS.buffer_storage)
+        { // map once and write straight into GPU visible memory for the lifetime of the buffer
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            OPENGL_EXTENSIONS.BufferStorage(GL_UNIFORM_BUFFER, total_size, nullptr, flags);
+            _mapped = (u8*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, total_size, flags);
+        }
+        else
+        { // 4.1 fallback; each push becomes a glBufferSubData into a region the GPU is not reading
+            glBufferData(GL_UNIFORM_BUFFER, total_size, nullptr, GL_STREAM_DRAW);
+        }
+    }
+
+    OpenGLUniformRingBuffer::~OpenGLUniformRingBuffer()
+    {
+        for (auto fence : _fences)
+            if (fence) glDeleteSync((GLsync)fence);
+
+        if (_mapped)
+        {
+            glBindBuffer(GL_UNIFORM_BUFFER, _id);
+            glUnmapBuffer(GL_UNIFORM_BUFFER);
+        }
+
+        glDeleteBuffers(1, &_id);
+    }
+
+    void OpenGLUniformRingBuffer::begin_frame()
+    {
+        u32 region = _frame % FRAMES_IN_FLIGHT;
+
+        if (auto fence = (GLsync)_fences[region])
+        { // the GPU may still be reading what we wrote FRAMES_IN_FLIGHT frames ago
+            while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+            glDeleteSync(fence);
+            _fences[region] = nullptr;
+        }
+
+        _offset = region * _frame_size;
+        _end = _offset + _frame_size;
+    }
+
+    void OpenGLUniformRingBuffer::end_frame()
+    {
+        u32 region = _frame % FRAMES_IN_FLIGHT;
+        _fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        _frame++;
+    }
+
+    void OpenGLUniformRingBuffer::push(UniformBlock binding, const void* data, u32 size)
+    {
+        if (_offset + size > _end)
+        {
+            std::cerr << "Uniform ring buffer overflow: " << _frame_size << " bytes per frame is not enough.\n";
+            throw std::runtime_error("Uniform ring buffer overflow");
+        }
+
+        if (_mapped)
+        {
+            std::memcpy(_mapped + _offset, data, size);
+        }
+        else
+        {
+            glBindBuffer(GL_UNIFORM_BUFFER, _id);
+            glBufferSubData(GL_UNIFORM_BUFFER, _offset, size, data);
+        }
+
+        glBindBufferRange(GL_UNIFORM_BUFFER, (u32)binding, _id, _offset, size);
+
+        // the next push has to start on an offset the driver accepts for glBindBufferRange
+        _offset += (size + _alignment - 1) / _alignment * _alignment;
+    }
 } // namespace inx
\ No newline at end of file
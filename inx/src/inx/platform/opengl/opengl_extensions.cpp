@@ -0,0 +1,77 @@
+#include "opengl_extensions.h"
+
+#include <cstring>
+#include <iostream>
+
+#include <SDL3/SDL_video.h>
+
+namespace inx
+{
+    OpenGLExtensions OPENGL_EXTENSIONS;
+
+    static bool _has_version(i32 major, i32 minor)
+    {
+        GLint gl_major, gl_minor;
+        glGetIntegerv(GL_MAJOR_VERSION, &gl_major);
+        glGetIntegerv(GL_MINOR_VERSION, &gl_minor);
+
+        return gl_major > major || (gl_major == major && gl_minor >= minor);
+    }
+
+    static bool _has_extension(const char* name)
+    {
+        GLint count;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++)
+        {
+            const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+            if (std::strcmp(extension, name) == 0) return true;
+        }
+
+        return false;
+    }
+
+    template<typename T>
+    static bool _load(T& function, const char* name)
+    {
+        function = (T)SDL_GL_GetProcAddress(name);
+        return function != nullptr;
+    }
+
+    void load_opengl_extensions()
+    {
+        auto& ext = OPENGL_EXTENSIONS;
+
+        if (_has_version(4, 4) || _has_extension("GL_ARB_buffer_storage"))
+            ext.buffer_storage = _load(ext.BufferStorage, "glBufferStorage");
+
+        if (_has_extension("GL_KHR_parallel_shader_compile"))
+            ext.parallel_shader_compile = _load(ext.MaxShaderCompilerThreads, "glMaxShaderCompilerThreadsKHR");
+        else if (_has_extension("GL_ARB_parallel_shader_compile"))
+            ext.parallel_shader_compile = _load(ext.MaxShaderCompilerThreads, "glMaxShaderCompilerThreadsARB");
+
+        // 0xffffffff lets the driver use as many compiler threads as it likes
+        if (ext.parallel_shader_compile)
+            ext.MaxShaderCompilerThreads(0xffffffff);
+
+        if (_has_version(4, 2) || _has_extension("GL_ARB_texture_storage"))
+            ext.texture_storage = _load(ext.TexStorage2D, "glTexStorage2D") && _load(ext.TexStorage3D, "glTexStorage3D");
+
+        ext.texture_filter_anisotropic = _has_version(4, 6) || _has_extension("GL_ARB_texture_filter_anisotropic") || _has_extension("GL_EXT_texture_filter_anisotropic");
+        if (ext.texture_filter_anisotropic)
+            glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &ext.max_anisotropy);
+
+        ext.texture_compression_s3tc = _has_extension("GL_EXT_texture_compression_s3tc");
+        ext.texture_compression_bptc = _has_version(4, 2) || _has_extension("GL_ARB_texture_compression_bptc");
+        ext.texture_compression_etc2 = _has_version(4, 3) || _has_extension("GL_ARB_ES3_compatibility");
+
+        std::cout << "OpenGL Extensions\n";
+        std::cout << " - Buffer storage:    " << (ext.buffer_storage ? "yes" : "no") << "\n";
+        std::cout << " - Parallel compile:  " << (ext.parallel_shader_compile ? "yes" : "no") << "\n";
+        std::cout << " - Texture storage:   " << (ext.texture_storage ? "yes" : "no") << "\n";
+        std::cout << " - Max anisotropy:    " << ext.max_anisotropy << "\n";
+        std::cout << " - BC1/BC3 (S3TC):    " << (ext.texture_compression_s3tc ? "yes" : "no") << "\n";
+        std::cout << " - BC7 (BPTC):        " << (ext.texture_compression_bptc ? "yes" : "no") << "\n";
+        std::cout << " - ETC2:              " << (ext.texture_compression_etc2 ? "yes" : "no") << "\n";
+    }
+} // namespace inx
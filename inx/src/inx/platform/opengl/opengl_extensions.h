@@ -0,0 +1,83 @@
+#ifndef __INX_OPENGL_EXTENSIONS_H__
+#define __INX_OPENGL_EXTENSIONS_H__
+
+#include <glad/glad.h>
+
+#include "../../types.h"
+
+// glad is generated for the 4.1 core profile only, so anything newer is declared here and loaded at runtime
+
+// GL_ARB_buffer_storage (core in 4.4)
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT   0x0040
+#define GL_MAP_COHERENT_BIT     0x0080
+#define GL_DYNAMIC_STORAGE_BIT  0x0100
+#define GL_CLIENT_STORAGE_BIT   0x0200
+#endif
+
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+// GL_KHR_parallel_shader_compile / GL_ARB_parallel_shader_compile (same enum values)
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR  0x91B0
+#define GL_COMPLETION_STATUS_KHR            0x91B1
+#endif
+
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+// GL_ARB_texture_storage (core in 4.2)
+typedef void (APIENTRYP PFNGLTEXSTORAGE2DPROC)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height);
+typedef void (APIENTRYP PFNGLTEXSTORAGE3DPROC)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth);
+
+// GL_EXT_texture_compression_s3tc (BC1/BC3)
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT     0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT    0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT    0x83F3
+#endif
+
+// GL_ARB_texture_compression_bptc (BC7; core in 4.2)
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM       0x8E8C
+#endif
+
+// GL_ARB_ES3_compatibility (ETC2; core in 4.3)
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2             0x9274
+#define GL_COMPRESSED_RGBA8_ETC2_EAC        0x9278
+#endif
+
+// GL_EXT_texture_filter_anisotropic / GL_ARB_texture_filter_anisotropic (same enum values; core in 4.6)
+#ifndef GL_TEXTURE_MAX_ANISOTROPY
+#define GL_TEXTURE_MAX_ANISOTROPY           0x84FE
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY       0x84FF
+#endif
+
+namespace inx
+{
+    struct OpenGLExtensions
+    {
+        bool buffer_storage = false;
+        bool parallel_shader_compile = false;
+        bool texture_compression_s3tc = false;
+        bool texture_compression_bptc = false;
+        bool texture_compression_etc2 = false;
+        bool texture_storage = false;
+        bool texture_filter_anisotropic = false;
+
+        /// @brief 1 when anisotropic filtering isn't available
+        float max_anisotropy = 1.f;
+
+        PFNGLBUFFERSTORAGEPROC BufferStorage = nullptr;
+        PFNGLMAXSHADERCOMPILERTHREADSKHRPROC MaxShaderCompilerThreads = nullptr;
+        PFNGLTEXSTORAGE2DPROC TexStorage2D = nullptr;
+        PFNGLTEXSTORAGE3DPROC TexStorage3D = nullptr;
+    };
+
+    /// @brief Filled in once by OpenGLRenderAPI::init(); everything is false/null until then
+    extern OpenGLExtensions OPENGL_EXTENSIONS;
+
+    void load_opengl_extensions();
+} // namespace inx
+
+#endif // __INX_OPENGL_EXTENSIONS_H__
@@ -1,4 +1,9 @@
 #include "../opengl.h"
+#include "opengl_extensions.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
 
 #include <glad/glad.h>
 
@@ -6,6 +11,8 @@ namespace inx
 {
     void OpenGLRenderAPI::init() const 
     {
+        load_opengl_extensions();
+
         glEnable(GL_DEPTH_TEST);
     }
 
@@ -23,4 +30,201 @@ namespace inx
     {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     }
+
+    void OpenGLRenderAPI::blend(BlendMode mode) const
+    {
+        switch (mode)
+        {
+            case BlendMode::None:
+            {
+                glDisable(GL_BLEND);
+            } break;
+
+            case BlendMode::Alpha:
+            {
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            } break;
+
+            case BlendMode::Additive:
+            {
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+            } break;
+        }
+    }
+
+    u32 OpenGLRenderAPI::max_texture_units() const
+    {
+        GLint units;
+        glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &units);
+        return (u32)units;
+    }
+
+    struct FramebufferFormats
+    {
+        GLenum colour;
+        GLenum depth_stencil; // GL_NONE when there is no depth or stencil
+        GLenum depth_stencil_attachment;
+        i32 samples;
+    };
+
+    /// @brief Renderbuffer formats matching the default framebuffer's attachments
+    static FramebufferFormats _default_framebuffer_formats()
+    {
+        GLint previous_framebuffer;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous_framebuffer);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+
+        auto query = [](GLenum attachment, GLenum parameter) {
+            GLint value = 0;
+            glGetFramebufferAttachmentParameteriv(GL_DRAW_FRAMEBUFFER, attachment, parameter, &value);
+            return value;
+        };
+
+        FramebufferFormats formats;
+
+        const GLint red = query(GL_BACK_LEFT, GL_FRAMEBUFFER_ATTACHMENT_RED_SIZE);
+        const GLint alpha = query(GL_BACK_LEFT, GL_FRAMEBUFFER_ATTACHMENT_ALPHA_SIZE);
+        const bool srgb = query(GL_BACK_LEFT, GL_FRAMEBUFFER_ATTACHMENT_COLOR_ENCODING) == GL_SRGB;
+
+        if (srgb)               formats.colour = GL_SRGB8_ALPHA8;
+        else if (red > 8)       formats.colour = GL_RGB10_A2;
+        else if (alpha == 0)    formats.colour = GL_RGB8;
+        else                    formats.colour = GL_RGBA8;
+
+        const GLint depth = query(GL_DEPTH, GL_FRAMEBUFFER_ATTACHMENT_DEPTH_SIZE);
+        const GLint stencil = query(GL_STENCIL, GL_FRAMEBUFFER_ATTACHMENT_STENCIL_SIZE);
+
+        formats.depth_stencil_attachment = GL_DEPTH_ATTACHMENT;
+        if (stencil > 0)
+        {
+            formats.depth_stencil = depth > 24 ? GL_DEPTH32F_STENCIL8 : GL_DEPTH24_STENCIL8;
+            formats.depth_stencil_attachment = GL_DEPTH_STENCIL_ATTACHMENT;
+        }
+        else if (depth > 24)    formats.depth_stencil = GL_DEPTH_COMPONENT32F;
+        else if (depth > 16)    formats.depth_stencil = GL_DEPTH_COMPONENT24;
+        else if (depth > 0)     formats.depth_stencil = GL_DEPTH_COMPONENT16;
+        else                    formats.depth_stencil = GL_NONE;
+
+        glGetIntegerv(GL_SAMPLES, &formats.samples);
+
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previous_framebuffer);
+        return formats;
+    }
+
+    void OpenGLRenderAPI::warm_up(const std::vector<WarmUpEntry>& entries) const
+    {
+        if (entries.empty()) return;
+
+        auto start = std::chrono::steady_clock::now();
+
+        GLint previous_framebuffer, previous_program, previous_vertex_array;
+        GLint previous_viewport[4];
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous_framebuffer);
+        glGetIntegerv(GL_CURRENT_PROGRAM, &previous_program);
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previous_vertex_array);
+        glGetIntegerv(GL_VIEWPORT, previous_viewport);
+
+        GLboolean previous_blend = glIsEnabled(GL_BLEND);
+        GLint previous_blend_func[4];
+        glGetIntegerv(GL_BLEND_SRC_RGB, &previous_blend_func[0]);
+        glGetIntegerv(GL_BLEND_DST_RGB, &previous_blend_func[1]);
+        glGetIntegerv(GL_BLEND_SRC_ALPHA, &previous_blend_func[2]);
+        glGetIntegerv(GL_BLEND_DST_ALPHA, &previous_blend_func[3]);
+
+        // 1x1 target with the default framebuffer's formats and sample count, so the driver builds the same variants
+        // it will need when drawing for real
+        const FramebufferFormats formats = _default_framebuffer_formats();
+
+        u32 framebuffer, renderbuffers[2];
+        glGenFramebuffers(1, &framebuffer);
+        glGenRenderbuffers(2, renderbuffers);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, formats.samples, formats.colour, 1, 1);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+
+        if (formats.depth_stencil != GL_NONE)
+        {
+            glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+            glRenderbufferStorageMultisample(GL_RENDERBUFFER, formats.samples, formats.depth_stencil, 1, 1);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, formats.depth_stencil_attachment, GL_RENDERBUFFER, renderbuffers[1]);
+        }
+
+        glViewport(0, 0, 1, 1);
+
+        // drawing with a uniform block that has no buffer behind it is undefined, so every shared block gets a zeroed
+        // buffer large enough for any of them; whatever was bound before is put back afterwards
+        GLint previous_blocks[(u32)UniformBlock::COUNT][3];
+        for (u32 block = 0; block < (u32)UniformBlock::COUNT; block++)
+        {
+            glGetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, block, &previous_blocks[block][0]);
+            glGetIntegeri_v(GL_UNIFORM_BUFFER_START, block, &previous_blocks[block][1]);
+            glGetIntegeri_v(GL_UNIFORM_BUFFER_SIZE, block, &previous_blocks[block][2]);
+        }
+
+        const u32 block_size = (u32)std::max({ sizeof(std140::Camera), sizeof(std140::Lights), sizeof(std140::Object) });
+        const std::vector<u8> zeros(block_size);
+
+        u32 block_buffer;
+        glGenBuffers(1, &block_buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, block_buffer);
+        glBufferData(GL_UNIFORM_BUFFER, block_size, zeros.data(), GL_STATIC_DRAW);
+        for (u32 block = 0; block < (u32)UniformBlock::COUNT; block++)
+            glBindBufferBase(GL_UNIFORM_BUFFER, block, block_buffer);
+
+        for (const auto& entry : entries)
+        {
+            // binding also finishes any compile still in flight
+            entry.shader->bind();
+            entry.vertex_array->bind();
+            if (entry.texture) entry.texture->bind(GL_TEXTURE0);
+            blend(entry.blend);
+
+            // the element buffer is part of the vertex array's state, so this says how it's drawn for real
+            GLint index_buffer;
+            glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &index_buffer);
+            if (index_buffer)   glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_INT, nullptr);
+            else                glDrawArrays(GL_TRIANGLES, 0, 3);
+        }
+
+        // wait for the GPU so every deferred compile and allocation actually happens now
+        glFinish();
+
+        for (u32 block = 0; block < (u32)UniformBlock::COUNT; block++)
+        {
+            const GLint* previous = previous_blocks[block];
+            if (previous[2] > 0)    glBindBufferRange(GL_UNIFORM_BUFFER, block, previous[0], previous[1], previous[2]);
+            else                    glBindBufferBase(GL_UNIFORM_BUFFER, block, previous[0]);
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, previous_framebuffer);
+        glViewport(previous_viewport[0], previous_viewport[1], previous_viewport[2], previous_viewport[3]);
+        glUseProgram(previous_program);
+        glBindVertexArray(previous_vertex_array);
+
+        if (previous_blend) glEnable(GL_BLEND);
+        else                glDisable(GL_BLEND);
+        glBlendFuncSeparate(previous_blend_func[0], previous_blend_func[1], previous_blend_func[2], previous_blend_func[3]);
+
+        glDeleteBuffers(1, &block_buffer);
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteRenderbuffers(2, renderbuffers);
+
+        auto elapsed = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Warmed up " << entries.size() << " pipeline states in " << elapsed << "ms\n";
+    }
+
+    bool OpenGLRenderAPI::start_upload_thread(SDL_Window* window) const
+    {
+        return OpenGLUploadThread::start(window);
+    }
+
+    void OpenGLRenderAPI::stop_upload_thread() const
+    {
+        OpenGLUploadThread::stop();
+    }
 } // namespace inx
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "../opengl.h"
+#include "opengl_extensions.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace inx
+{
+    struct SamplerCacheState
+    {
+        /// @brief keyed by _key(); a Sampler is small enough to pack whole into one integer
+        std::unordered_map<u64, u32> samplers;
+
+        /// @brief sampler object bound to each texture unit, so rebinding the same one is skipped
+        std::vector<u32> bound;
+    };
+
+    static SamplerCacheState SAMPLER_CACHE;
+
+    static u64 _key(const Sampler& sampler)
+    {
+        u64 key = (u64)sampler.min_filter;
+        key |= (u64)sampler.mag_filter << 2;
+        key |= (u64)sampler.mip_filter << 4;
+        key |= (u64)sampler.wrap_u << 6;
+        key |= (u64)sampler.wrap_v << 8;
+        key |= (u64)sampler.anisotropy << 10;
+        return key;
+    }
+
+    static GLenum _min_filter(const Sampler& sampler)
+    {
+        bool linear = sampler.min_filter == TextureFilter::Linear;
+        switch(sampler.mip_filter)
+        {
+            case MipFilter::None:       return linear ? GL_LINEAR : GL_NEAREST;
+            case MipFilter::Nearest:    return linear ? GL_LINEAR_MIPMAP_NEAREST : GL_NEAREST_MIPMAP_NEAREST;
+            case MipFilter::Linear:     return linear ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_LINEAR;
+        }
+
+        return GL_LINEAR;
+    }
+
+    static GLenum _wrap(TextureWrap wrap)
+    {
+        switch(wrap)
+        {
+            case TextureWrap::Repeat:           return GL_REPEAT;
+            case TextureWrap::MirroredRepeat:   return GL_MIRRORED_REPEAT;
+            case TextureWrap::ClampToEdge:      return GL_CLAMP_TO_EDGE;
+        }
+
+        return GL_REPEAT;
+    }
+
+    u32 OpenGLSamplerCache::_get(const Sampler& sampler)
+    {
+        auto& cache = SAMPLER_CACHE;
+
+        u64 key = _key(sampler);
+        auto it = cache.samplers.find(key);
+        if (it != cache.samplers.end()) return it->second;
+
+        u32 id;
+        glGenSamplers(1, &id);
+        glSamplerParameteri(id, GL_TEXTURE_MIN_FILTER, _min_filter(sampler));
+        glSamplerParameteri(id, GL_TEXTURE_MAG_FILTER, sampler.mag_filter == TextureFilter::Linear ? GL_LINEAR : GL_NEAREST);
+        glSamplerParameteri(id, GL_TEXTURE_WRAP_S, _wrap(sampler.wrap_u));
+        glSamplerParameteri(id, GL_TEXTURE_WRAP_T, _wrap(sampler.wrap_v));
+
+        const auto& ext = OPENGL_EXTENSIONS;
+        if (ext.texture_filter_anisotropic && sampler.anisotropy > 1)
+            glSamplerParameterf(id, GL_TEXTURE_MAX_ANISOTROPY, std::min((float)sampler.anisotropy, ext.max_anisotropy));
+
+        cache.samplers.emplace(key, id);
+        return id;
+    }
+
+    void OpenGLSamplerCache::bind(unsigned int slot, const Sampler& sampler)
+    {
+        auto& cache = SAMPLER_CACHE;
+
+        u32 unit = slot - GL_TEXTURE0;
+        u32 id = _get(sampler);
+
+        if (unit >= cache.bound.size()) cache.bound.resize(unit + 1, 0);
+        if (cache.bound[unit] == id) return;
+
+        glBindSampler(unit, id);
+        cache.bound[unit] = id;
+    }
+
+    u32 OpenGLSamplerCache::count()
+    {
+        return (u32)SAMPLER_CACHE.samplers.size();
+    }
+} // namespace inx
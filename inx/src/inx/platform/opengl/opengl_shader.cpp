@@ -1,37 +1,131 @@
 #include "../opengl.h"
+#include "opengl_extensions.h"
+#include "../../core.h"
 
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
 #include <fstream>
-#include <sstream>
 #include <iostream>
 
 #include <glad/glad.h>
 #include <glm/gtc/type_ptr.hpp>
 
-u32 _load_shader(const std::filesystem::path& path, GLenum type)
+static bool _is_float_type(GLenum type)
 {
-    std::string code;
-    { // obtaining the actual code we care about
-        std::ifstream fstream;
-        fstream.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        fstream.open(path.string());
+    switch (type)
+    {
+        case GL_FLOAT:
+        case GL_FLOAT_VEC2:
+        case GL_FLOAT_VEC3:
+        case GL_FLOAT_VEC4:
+        case GL_FLOAT_MAT2:
+        case GL_FLOAT_MAT3:
+        case GL_FLOAT_MAT4:
+            return true;
+    }
+
+    return false;
+}
+
+/// @brief size in bytes of one element of a uniform of the given type
+static u32 _uniform_size(GLenum type)
+{
+    switch (type)
+    {
+        case GL_FLOAT_VEC2:
+        case GL_INT_VEC2:
+        case GL_BOOL_VEC2:      return 4 * 2;
+        case GL_FLOAT_VEC3:
+        case GL_INT_VEC3:
+        case GL_BOOL_VEC3:      return 4 * 3;
+        case GL_FLOAT_VEC4:
+        case GL_INT_VEC4:
+        case GL_BOOL_VEC4:
+        case GL_FLOAT_MAT2:     return 4 * 4;
+        case GL_FLOAT_MAT3:     return 4 * 9;
+        case GL_FLOAT_MAT4:     return 4 * 16;
+    }
+
+    // scalars and samplers
+    return 4;
+}
+
+static inx::UniformStats UNIFORM_STATS;
+
+#ifndef NDEBUG
+static bool _is_sampler(GLenum type)
+{
+    switch (type)
+    {
+        case GL_SAMPLER_1D:
+        case GL_SAMPLER_2D:
+        case GL_SAMPLER_3D:
+        case GL_SAMPLER_CUBE:
+        case GL_SAMPLER_1D_ARRAY:
+        case GL_SAMPLER_2D_ARRAY:
+        case GL_SAMPLER_2D_SHADOW:
+        case GL_SAMPLER_2D_ARRAY_SHADOW:
+        case GL_SAMPLER_CUBE_SHADOW:
+        case GL_SAMPLER_2D_MULTISAMPLE:
+        case GL_SAMPLER_BUFFER:
+        case GL_INT_SAMPLER_2D:
+        case GL_INT_SAMPLER_2D_ARRAY:
+        case GL_UNSIGNED_INT_SAMPLER_2D:
+        case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+            return true;
+    }
 
-        std::stringstream sstream;
-        sstream << fstream.rdbuf();
+    return false;
+}
+
+static void _check_uniform_type(const inx::UniformId& id, GLenum expected)
+{
+    // setting a missing uniform is a no-op in GL, so there's nothing to check
+    if (!id.valid()) return;
 
-        fstream.close();
+    bool matches = id.type == expected;
+    if (expected == GL_INT) matches |= id.type == GL_BOOL || _is_sampler(id.type);
+    if (expected == GL_FLOAT) matches |= id.type == GL_BOOL;
 
-        code = sstream.str();
+    if (!matches)
+    {
+        std::cerr << "Uniform type mismatch at location " << id.location << ": expected 0x" << std::hex << expected << ", got 0x" << id.type << std::dec << "\n";
+        throw std::runtime_error("Uniform type mismatch");
     }
+}
+#else
+#define _check_uniform_type(id, expected)
+#endif
 
+static std::string _read_file(const std::filesystem::path& path)
+{
+    // from a mounted pack when there is one; preprocessing builds a new string anyway, so this is the only copy
+    inx::AssetFile file = inx::AssetPack::open(path);
+    if (!file.is_open())
+    {
+        std::cerr << "Could not open shader file: " << path.string() << "\n";
+        throw std::runtime_error("Could not open shader file: " + path.string());
+    }
+
+    return std::string((const char*)file.data(), file.size());
+}
+
+static u32 _compile_shader(const std::string& code, GLenum type)
+{
     // gl functions require a c string
     const char* code_str = code.c_str();
 
-    // create the actual shader program
+    // issue the compile but don't ask for the result; querying it here would make the driver finish it first
     u32 shader = glCreateShader(type);
     glShaderSource(shader, 1, &code_str, NULL);
     glCompileShader(shader);
 
-    // check for errors
+    return shader;
+}
+
+static void _check_shader(u32 shader)
+{
     int success;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
     if (!success)
@@ -40,91 +134,658 @@ u32 _load_shader(const std::filesystem::path& path, GLenum type)
         glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &max_length);
         
         std::vector<GLchar> log(max_length);
-        glGetShaderInfoLog(shader, 1024, NULL, log.data());
+        glGetShaderInfoLog(shader, max_length, NULL, log.data());
 
         std::cerr << "Could not compile shader: " << log.data() << "\n";
         throw std::runtime_error(log.data());
     }
+}
 
-    // if no error found, we just return the shader id
-    return shader;
+/// @brief Header written in front of every cached program binary
+struct ProgramBinaryHeader
+{
+    static constexpr u32 MAGIC = 0x42584e49; // "INXB"
+    static constexpr u32 VERSION = 1;
+
+    u32 magic;
+    u32 version;
+    u32 format;
+    u32 size;
+};
+
+/// @brief Hash of everything that can invalidate a program binary besides the source itself
+static u64 _driver_hash()
+{
+    static u64 hash = 0;
+    if (hash == 0)
+    {
+        hash = inx::hash_fnv1a64((const char*)glGetString(GL_VENDOR));
+        hash = inx::hash_fnv1a64((const char*)glGetString(GL_RENDERER), hash);
+        hash = inx::hash_fnv1a64((const char*)glGetString(GL_VERSION), hash);
+    }
+
+    return hash;
+}
+
+static bool _binary_cache_supported()
+{
+    GLint format_count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+    return format_count > 0;
+}
+
+static std::filesystem::path _binary_cache_path(u64 key)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return std::filesystem::path(CACHE_PATH) / "shaders" / name;
+}
+
+/// @brief Try to link a program from a cached binary
+/// @return False if there is no cached binary or the driver rejected it; the caller should compile from source
+static bool _load_program_binary(u32 program, const std::filesystem::path& path)
+{
+    std::ifstream fstream(path, std::ios::binary);
+    if (!fstream) return false;
+
+    ProgramBinaryHeader header;
+    if (!fstream.read((char*)&header, sizeof(header))) return false;
+    if (header.magic != ProgramBinaryHeader::MAGIC || header.version != ProgramBinaryHeader::VERSION) return false;
+
+    // the binary fills the rest of the file; a truncated or corrupt entry is a miss, not a huge allocation
+    auto start = fstream.tellg();
+    fstream.seekg(0, std::ios::end);
+    if (!fstream || fstream.tellg() - start != (std::streamoff)header.size) return false;
+    fstream.seekg(start);
+
+    std::vector<char> binary(header.size);
+    if (!fstream.read(binary.data(), binary.size())) return false;
+
+    // drivers are free to reject binaries at any time (e.g. after an update), which just fails the link
+    glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    return success;
+}
+
+static void _save_program_binary(u32 program, const std::filesystem::path& path)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    ProgramBinaryHeader header = { ProgramBinaryHeader::MAGIC, ProgramBinaryHeader::VERSION, 0, 0 };
+    std::vector<char> binary(length);
+
+    GLenum format;
+    glGetProgramBinary(program, length, nullptr, &format, binary.data());
+    header.format = format;
+    header.size = (u32)length;
+
+    // the cache is purely an optimisation, so failing to write it is not an error
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    std::ofstream fstream(path, std::ios::binary | std::ios::trunc);
+    fstream.write((const char*)&header, sizeof(header));
+    fstream.write(binary.data(), binary.size());
 }
 
 namespace inx
 {
-    OpenGLShader::OpenGLShader(const std::filesystem::path& vertex_filepath, const std::filesystem::path& fragment_filepath)
+    /// @brief Every program currently alive, keyed by the hash of its preprocessed sources
+    static std::unordered_map<u64, std::weak_ptr<OpenGLProgram>> PROGRAM_CACHE;
+
+    static std::string _preprocess(const std::filesystem::path& filepath, const ShaderDefines& defines, std::vector<std::filesystem::path>& included, u32 source_number)
+    {
+        auto code = _read_file(filepath);
+        included.push_back(std::filesystem::weakly_canonical(filepath));
+
+        std::string result;
+        result.reserve(code.size());
+
+        size_t line_start = 0;
+        u32 line_number = 1;
+        while (line_start < code.size())
+        {
+            size_t line_end = code.find('\n', line_start);
+            if (line_end == std::string::npos) line_end = code.size();
+
+            std::string_view line(code.data() + line_start, line_end - line_start);
+            size_t first = line.find_first_not_of(" \t");
+            std::string_view directive = first == std::string_view::npos ? std::string_view() : line.substr(first);
+
+            if (directive.starts_with("#include"))
+            { // splice the included file in place, then restore line numbering for error messages
+                size_t open = directive.find('"');
+                size_t close = directive.find('"', open + 1);
+                if (open == std::string_view::npos || close == std::string_view::npos)
+                {
+                    std::cerr << "Malformed #include in " << filepath.string() << ":" << line_number << "\n";
+                    throw std::runtime_error("Malformed #include in " + filepath.string());
+                }
+
+                auto include_path = filepath.parent_path() / directive.substr(open + 1, close - open - 1);
+                auto canonical = std::filesystem::weakly_canonical(include_path);
+                if (std::find(included.begin(), included.end(), canonical) == included.end())
+                {
+                    u32 include_number = (u32)included.size();
+                    result += "#line 1 " + std::to_string(include_number) + "\n";
+                    result += _preprocess(include_path, {}, included, include_number);
+                    result += "#line " + std::to_string(line_number + 1) + " " + std::to_string(source_number) + "\n";
+                }
+            }
+            else
+            {
+                result.append(line);
+                result += '\n';
+
+                if (directive.starts_with("#version") && !defines.empty())
+                { // defines have to come after #version but before anything that might use them
+                    for (const auto& [name, value] : defines)
+                        result += "#define " + name + " " + value + "\n";
+
+                    result += "#line " + std::to_string(line_number + 1) + " " + std::to_string(source_number) + "\n";
+                }
+            }
+
+            line_start = line_end + 1;
+            line_number++;
+        }
+
+        return result;
+    }
+
+    std::string preprocess_shader(const std::filesystem::path& filepath, const ShaderDefines& defines)
+    {
+        std::vector<std::filesystem::path> included;
+        return _preprocess(filepath, defines, included, 0);
+    }
+
+    OpenGLShader::OpenGLShader(const std::filesystem::path& vertex_filepath, const std::filesystem::path& fragment_filepath, const ShaderDefines& defines)
+        : OpenGLShader(preprocess_shader(vertex_filepath, defines), preprocess_shader(fragment_filepath, defines))
+    {
+    }
+
+    OpenGLShader::OpenGLShader(std::string vertex_code, std::string fragment_code)
+    {
+        std::vector<ShaderSource> sources = {
+            { GL_VERTEX_SHADER, std::move(vertex_code) },
+            { GL_FRAGMENT_SHADER, std::move(fragment_code) },
+        };
+
+        // the vertex stage's length goes between the two, so moving text from one stage to the other changes the key
+        const u64 vertex_size = sources[0].code.size();
+        u64 key = hash_fnv1a64(sources[0].code);
+        key = hash_fnv1a64(std::string_view((const char*)&vertex_size, sizeof(vertex_size)), key);
+        key = hash_fnv1a64(sources[1].code, key);
+        _program = OpenGLProgram::acquire(sources, key);
+    }
+
+    void OpenGLShader::bind() const
+    {
+        _program->ensure_ready();
+        glUseProgram(_program->id());
+    }
+
+    /// @brief Insert lines straight after the #version line, keeping the original line numbering intact
+    static void _insert_after_version(std::string& code, std::string_view lines)
+    {
+        size_t version = code.find("#version");
+        size_t insert_at = version == std::string::npos ? 0 : code.find('\n', version) + 1;
+        auto line_number = std::count(code.begin(), code.begin() + insert_at, '\n') + 1;
+
+        code.insert(insert_at, std::string(lines) + "#line " + std::to_string(line_number) + " 0\n");
+    }
+
+    OpenGLPipelineShader::OpenGLPipelineShader(const std::filesystem::path& vertex_filepath, const std::filesystem::path& fragment_filepath, const ShaderDefines& defines)
+        : OpenGLPipelineShader(preprocess_shader(vertex_filepath, defines), preprocess_shader(fragment_filepath, defines))
+    {
+    }
+
+    OpenGLPipelineShader::OpenGLPipelineShader(std::string vertex_code, std::string fragment_code)
+    {
+        ShaderSource vertex = { GL_VERTEX_SHADER, std::move(vertex_code) };
+        ShaderSource fragment = { GL_FRAGMENT_SHADER, std::move(fragment_code) };
+
+        // separable vertex stages have to declare the built-in outputs they write
+        _insert_after_version(vertex.code, "#extension GL_ARB_separate_shader_objects : enable\nout gl_PerVertex { vec4 gl_Position; };\n");
+
+        // each stage is keyed on its own source, so any pipeline using the same file and defines shares it
+        _stages[0] = OpenGLProgram::acquire({ vertex }, hash_fnv1a64(vertex.code) ^ GL_VERTEX_SHADER, true);
+        _stages[1] = OpenGLProgram::acquire({ fragment }, hash_fnv1a64(fragment.code) ^ GL_FRAGMENT_SHADER, true);
+
+        glGenProgramPipelines(1, &_id);
+    }
+
+    OpenGLPipelineShader::~OpenGLPipelineShader()
+    {
+        glDeleteProgramPipelines(1, &_id);
+    }
+
+    void OpenGLPipelineShader::bind() const
+    {
+        if (!_stages_attached)
+        { // stages can only be attached once they have linked successfully
+            _stages[0]->ensure_ready();
+            _stages[1]->ensure_ready();
+
+            glUseProgramStages(_id, GL_VERTEX_SHADER_BIT, _stages[0]->id());
+            glUseProgramStages(_id, GL_FRAGMENT_SHADER_BIT, _stages[1]->id());
+            _stages_attached = true;
+        }
+
+        // a program bound with glUseProgram takes priority over the pipeline
+        glUseProgram(0);
+        glBindProgramPipeline(_id);
+    }
+
+    bool OpenGLPipelineShader::is_ready() const
+    {
+        // evaluate every stage so each one gets finished as soon as it can be
+        bool ready = true;
+        for (const auto& stage : _stages)
+            ready &= stage->is_ready();
+
+        return ready;
+    }
+
+    UniformId OpenGLPipelineShader::uniform(std::string_view name) const
+    {
+        UniformId result;
+
+        u32 hash = hash_fnv1a(name);
+        auto it = _uniform_lookup.find(hash);
+        if (it == _uniform_lookup.end())
+        { // the same name can be declared in more than one stage, and each stage has its own copy
+            std::array<UniformId, STAGE_COUNT> ids;
+            for (u32 stage = 0; stage < STAGE_COUNT; stage++)
+            {
+                ids[stage] = _stages[stage]->find_uniform(name);
+                ids[stage].stage = stage;
+            }
+
+#ifndef NDEBUG
+            if (!ids[0].valid() && !ids[1].valid())
+                std::cerr << "Uniform [" << name << "] not found in any stage of program pipeline " << _id << "\n";
+#endif
+
+            it = _uniform_lookup.emplace(hash, (u32)_uniforms.size()).first;
+            _uniforms.push_back({ std::string(name), ids });
+        }
+#ifndef NDEBUG
+        else if (_uniforms[it->second].name != name)
+        { // two names hashing to the same value would silently alias each other
+            std::cerr << "Uniform hash collision: " << name << " and " << _uniforms[it->second].name << "\n";
+            throw std::runtime_error("Uniform hash collision: " + std::string(name));
+        }
+#endif
+
+        for (const auto& id : _uniforms[it->second].ids)
+        {
+            if (id.valid())
+            {
+                result = id;
+                break;
+            }
+        }
+
+        result.index = it->second;
+        return result;
+    }
+
+    template<typename F>
+    void OpenGLPipelineShader::for_each_stage(UniformId id, F&& set) const
+    {
+        if (!id.valid()) return;
+
+        for (u32 stage = 0; stage < STAGE_COUNT; stage++)
+            set(*_stages[stage], _uniforms[id.index].ids[stage]);
+    }
+
+    void OpenGLPipelineShader::set_int(UniformId id, int i) const
+    {
+        for_each_stage(id, [&](const OpenGLProgram& program, UniformId stage_id) { program.set_int(stage_id, i); });
+    }
+
+    void OpenGLPipelineShader::set_ints(UniformId id, int* ints, u32 count) const
+    {
+        for_each_stage(id, [&](const OpenGLProgram& program, UniformId stage_id) { program.set_ints(stage_id, ints, count); });
+    }
+
+    void OpenGLPipelineShader::set_float(UniformId id, float f) const
+    {
+        for_each_stage(id, [&](const OpenGLProgram& program, UniformId stage_id) { program.set_float(stage_id, f); });
+    }
+
+    void OpenGLPipelineShader::set_vec3(UniformId id, const glm::vec3& vec) const
+    {
+        for_each_stage(id, [&](const OpenGLProgram& program, UniformId stage_id) { program.set_vec3(stage_id, vec); });
+    }
+
+    void OpenGLPipelineShader::set_mat4(UniformId id, const glm::mat4& mat) const
+    {
+        for_each_stage(id, [&](const OpenGLProgram& program, UniformId stage_id) { program.set_mat4(stage_id, mat); });
+    }
+
+    Ref<OpenGLProgram> OpenGLProgram::acquire(const std::vector<ShaderSource>& sources, u64 key, bool separable)
+    {
+        // reuse the variant if another shader already compiled these exact sources
+        if (auto it = PROGRAM_CACHE.find(key); it != PROGRAM_CACHE.end())
+            if (auto program = it->second.lock())
+                return program;
+
+        auto program = create_ref<OpenGLProgram>(sources, key, separable);
+        PROGRAM_CACHE[key] = program;
+        return program;
+    }
+
+    OpenGLProgram::OpenGLProgram(const std::vector<ShaderSource>& sources, u64 key, bool separable)
     {
-        // load/compile our base shaders
-        auto vert_id = _load_shader(vertex_filepath, GL_VERTEX_SHADER);
-        auto frag_id = _load_shader(fragment_filepath, GL_FRAGMENT_SHADER);
-        
-        // create our shader program
         _id = glCreateProgram();
-        glAttachShader(_id, vert_id);
-        glAttachShader(_id, frag_id);
+
+        // has to be set before either glProgramBinary or glLinkProgram
+        if (separable) glProgramParameteri(_id, GL_PROGRAM_SEPARABLE, GL_TRUE);
+
+        // a binary is only valid for the exact sources on the exact driver it came from
+        bool use_cache = _binary_cache_supported();
+        _pending.cache_path = _binary_cache_path(key ^ _driver_hash());
+
+        if (use_cache && _load_program_binary(_id, _pending.cache_path))
+        {
+            finish_link();
+            return;
+        }
+
+        _pending.save_binary = use_cache;
+        if (use_cache) glProgramParameteri(_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+        // with an upload thread the whole compile and link happens there; querying the status forces the driver
+        // to finish it on that thread rather than on our first use
+        if (OpenGLUploadThread::running())
+        {
+            _pending.ticket = OpenGLUploadThread::submit([this, sources]()
+            {
+                for (const auto& source : sources)
+                {
+                    u32 shader_id = _compile_shader(source.code, source.stage);
+                    glAttachShader(_id, shader_id);
+                    _pending.shader_ids.push_back(shader_id);
+                }
+
+                glLinkProgram(_id);
+
+                int success;
+                glGetProgramiv(_id, GL_LINK_STATUS, &success);
+            });
+            return;
+        }
+
+        // kick off every compile and the link without checking anything; the status is only queried once the
+        // program is needed, so the driver can work on it (and on other shaders) in the background
+        for (const auto& source : sources)
+        {
+            u32 shader_id = _compile_shader(source.code, source.stage);
+            glAttachShader(_id, shader_id);
+            _pending.shader_ids.push_back(shader_id);
+        }
+
         glLinkProgram(_id);
-        
-        // check for errors
+    }
+
+    OpenGLProgram::~OpenGLProgram()
+    {
+        // the upload thread may still be compiling into this program
+        if (_pending.ticket) _pending.ticket->wait();
+
+        for (auto shader_id : _pending.shader_ids)
+            glDeleteShader(shader_id);
+
+        glDeleteProgram(_id);
+    }
+
+    bool OpenGLProgram::is_ready() const
+    {
+        if (_ready) return true;
+
+        if (_pending.ticket && !_pending.ticket->complete()) return false;
+
+        if (OPENGL_EXTENSIONS.parallel_shader_compile)
+        { // non-blocking query; only true once compiling and linking are both done
+            GLint complete = GL_FALSE;
+            glGetProgramiv(_id, GL_COMPLETION_STATUS_KHR, &complete);
+            if (!complete) return false;
+        }
+
+        ensure_ready();
+        return true;
+    }
+
+    void OpenGLProgram::ensure_ready() const
+    {
+        // the program is logically const; finishing the link only fills in state derived from it
+        if (!_ready) const_cast<OpenGLProgram*>(this)->finish_link();
+    }
+
+    void OpenGLProgram::finish_link()
+    {
+        if (_pending.ticket)
+        {
+            _pending.ticket->wait();
+            _pending.ticket.reset();
+        }
+
         int success;
         glGetProgramiv(_id, GL_LINK_STATUS, &success);
         if (!success)
-        { // error found; find info and throw exception
+        { // a failed compile is the more useful error, so report that first
+            for (auto shader_id : _pending.shader_ids)
+                _check_shader(shader_id);
+
             GLint max_length;
             glGetProgramiv(_id, GL_INFO_LOG_LENGTH, &max_length);
-            
+
             std::vector<GLchar> log(max_length);
-            glGetProgramInfoLog(_id, 1024, NULL, log.data());
+            glGetProgramInfoLog(_id, max_length, NULL, log.data());
 
-            glDeleteShader(vert_id);
-            glDeleteShader(frag_id);
-            
+            std::cerr << "Could not link shader: " << log.data() << "\n";
             throw std::runtime_error(log.data());
         }
 
         // cleanup shaders
-        glDetachShader(_id, vert_id);
-        glDeleteShader(vert_id);
-        glDetachShader(_id, frag_id);
-        glDeleteShader(frag_id);
+        for (auto shader_id : _pending.shader_ids)
+        {
+            glDetachShader(_id, shader_id);
+            glDeleteShader(shader_id);
+        }
+
+        if (_pending.save_binary) _save_program_binary(_id, _pending.cache_path);
+        _pending = {};
+
+        reflect_uniforms();
+        bind_uniform_blocks();
+
+        _ready = true;
     }
 
-    OpenGLShader::~OpenGLShader()
+    void OpenGLProgram::reflect_uniforms()
     {
-        glDeleteProgram(_id);
+        GLint count, max_length;
+        glGetProgramiv(_id, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+        std::vector<GLchar> buffer(max_length);
+        for (GLint i = 0; i < count; i++)
+        {
+            GLsizei length;
+            GLint size;
+            GLenum type;
+            glGetActiveUniform(_id, (GLuint)i, max_length, &length, &size, &type, buffer.data());
+
+            std::string name(buffer.data(), length);
+            i32 location = glGetUniformLocation(_id, name.c_str());
+
+            // uniforms that live inside a uniform block have no location
+            if (location < 0) continue;
+
+            // reserve shadow storage for the whole uniform (every element, if it's an array)
+            u32 element_size = _uniform_size(type);
+            u32 shadow_offset = (u32)_shadow.size();
+            _shadow.resize(_shadow.size() + element_size * size);
+
+            if (size > 1 && name.ends_with("[0]"))
+            { // arrays are reported once as "name[0]"; make "name" and every "name[i]" resolvable too
+                std::string base = name.substr(0, name.size() - 3);
+                add_uniform(base, location, type, size, shadow_offset);
+                add_uniform(name, location, type, size, shadow_offset);
+                read_shadow(location, type, shadow_offset);
+
+                for (GLint element = 1; element < size; element++)
+                {
+                    std::string element_name = base + "[" + std::to_string(element) + "]";
+                    i32 element_location = glGetUniformLocation(_id, element_name.c_str());
+                    u32 element_offset = shadow_offset + element_size * element;
+
+                    add_uniform(element_name, element_location, type, size - element, element_offset);
+                    read_shadow(element_location, type, element_offset);
+                }
+            }
+            else
+            {
+                add_uniform(name, location, type, size, shadow_offset);
+                read_shadow(location, type, shadow_offset);
+            }
+        }
     }
 
-    void OpenGLShader::bind() const
+    void OpenGLProgram::read_shadow(i32 location, u32 type, u32 shadow_offset)
+    {
+        // uniforms start at zero unless the GLSL gives them an initializer, so read back whatever the linker left there
+        u8* shadow = _shadow.data() + shadow_offset;
+        if (_is_float_type(type))
+            glGetUniformfv(_id, location, (GLfloat*)shadow);
+        else
+            glGetUniformiv(_id, location, (GLint*)shadow);
+    }
+
+    bool OpenGLProgram::update_shadow(UniformId id, const void* data, u32 size) const
     {
-        glUseProgram(_id);
+        // setting a missing uniform is a no-op in GL; skip the call entirely
+        if (!id.valid()) return false;
+
+        const auto& info = _uniforms[id.index];
+        size = std::min(size, _uniform_size(info.type) * info.count);
+
+        u8* shadow = _shadow.data() + info.shadow_offset;
+        if (std::memcmp(shadow, data, size) == 0)
+        {
+            UNIFORM_STATS.elided++;
+            return false;
+        }
+
+        std::memcpy(shadow, data, size);
+        UNIFORM_STATS.uploads++;
+        return true;
+    }
+
+    UniformStats OpenGLProgram::uniform_stats()
+    {
+        return UNIFORM_STATS;
+    }
+
+    void OpenGLProgram::reset_uniform_stats()
+    {
+        UNIFORM_STATS = {};
+    }
+
+    void OpenGLProgram::bind_uniform_blocks()
+    {
+        for (u32 block = 0; block < (u32)UniformBlock::COUNT; block++)
+        {
+            u32 index = glGetUniformBlockIndex(_id, uniform_block_name((UniformBlock)block));
+            if (index != GL_INVALID_INDEX)
+                glUniformBlockBinding(_id, index, block);
+        }
+    }
+
+    void OpenGLProgram::add_uniform(const std::string& name, i32 location, u32 type, i32 count, u32 shadow_offset)
+    {
+        u32 hash = hash_fnv1a(name);
+
+#ifndef NDEBUG
+        if (auto it = _uniform_lookup.find(hash); it != _uniform_lookup.end() && _uniforms[it->second].name != name)
+        { // two names hashing to the same value would silently alias each other
+            std::cerr << "Uniform hash collision: " << name << " and " << _uniforms[it->second].name << "\n";
+            throw std::runtime_error("Uniform hash collision: " + name);
+        }
+#endif
+
+        _uniform_lookup[hash] = (u32)_uniforms.size();
+        _uniforms.push_back({ name, location, type, count, shadow_offset });
+    }
+
+    UniformId OpenGLProgram::find_uniform(std::string_view name) const
+    {
+        ensure_ready();
+
+        UniformId result;
+
+        if (auto it = _uniform_lookup.find(hash_fnv1a(name)); it != _uniform_lookup.end())
+        {
+            const auto& info = _uniforms[it->second];
+            result.location = info.location;
+            result.index = it->second;
+            result.type = info.type;
+        }
+
+        return result;
+    }
+
+    UniformId OpenGLProgram::uniform(std::string_view name) const
+    {
+        auto result = find_uniform(name);
+
+#ifndef NDEBUG
+        if (!result.valid())
+            std::cerr << "Uniform [" << name << "] not found in shader program " << _id << "\n";
+#endif
+
+        return result;
     }
 
-    void OpenGLShader::set_int(const std::string& name, int i) const
+    void OpenGLProgram::set_int(UniformId id, int i) const
     {
-        auto location = glGetUniformLocation(_id, name.c_str());
-        glUniform1iv(location, 1, &i);
+        _check_uniform_type(id, GL_INT);
+        if (update_shadow(id, &i, sizeof(int)))
+            glProgramUniform1iv(_id, id.location, 1, &i);
     }
 
-    void OpenGLShader::set_ints(const std::string& name, int* ints, u32 count) const
+    void OpenGLProgram::set_ints(UniformId id, int* ints, u32 count) const
     {
-        auto location = glGetUniformLocation(_id, name.c_str());
-        glUniform1iv(location, count, ints);
+        _check_uniform_type(id, GL_INT);
+        if (update_shadow(id, ints, sizeof(int) * count))
+            glProgramUniform1iv(_id, id.location, count, ints);
     }
 
-    void OpenGLShader::set_float(const std::string& name, float f) const
+    void OpenGLProgram::set_float(UniformId id, float f) const
     {
-        auto location = glGetUniformLocation(_id, name.c_str());
-        glUniform1fv(location, 1, &f);
+        _check_uniform_type(id, GL_FLOAT);
+        if (update_shadow(id, &f, sizeof(float)))
+            glProgramUniform1fv(_id, id.location, 1, &f);
     }
 
-    void OpenGLShader::set_vec3(const std::string& name, const glm::vec3& vec) const
+    void OpenGLProgram::set_vec3(UniformId id, const glm::vec3& vec) const
     {
-        auto location = glGetUniformLocation(_id, name.c_str());
-        glUniform3fv(location, 1, &vec[0]);
+        _check_uniform_type(id, GL_FLOAT_VEC3);
+        if (update_shadow(id, &vec[0], sizeof(float) * 3))
+            glProgramUniform3fv(_id, id.location, 1, &vec[0]);
     }
 
-    void OpenGLShader::set_mat4(const std::string& name, const glm::mat4& mat) const
+    void OpenGLProgram::set_mat4(UniformId id, const glm::mat4& mat) const
     {
-        auto location = glGetUniformLocation(_id, name.c_str());
-        glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(mat));
+        _check_uniform_type(id, GL_FLOAT_MAT4);
+        if (update_shadow(id, glm::value_ptr(mat), sizeof(float) * 16))
+            glProgramUniformMatrix4fv(_id, id.location, 1, GL_FALSE, glm::value_ptr(mat));
     }
 } // namespace inx
\ No newline at end of file
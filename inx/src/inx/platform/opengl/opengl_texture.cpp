@@ -1,83 +1,788 @@
 #include "../opengl.h"
+#include "opengl_extensions.h"
+#include "../../core.h"
+#include "../../resources/resources_internal.h"
 
-#include <glad/glad.h>
-#include <stb/stb_image.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <iostream>
 
+#include <glad/glad.h>
+
 namespace inx
 {
     static u32 convert(ImageFormat format)
     {
         switch(format)
         {
-            case ImageFormat::RGB8:     return GL_RGB8;
-            case ImageFormat::RGBA8:    return GL_RGBA8;
+            case ImageFormat::R8:           return GL_R8;
+            case ImageFormat::RGB8:         return GL_RGB8;
+            case ImageFormat::RGBA8:        return GL_RGBA8;
+            case ImageFormat::BC1_RGB:      return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+            case ImageFormat::BC1:          return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+            case ImageFormat::BC3:          return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            case ImageFormat::BC7:          return GL_COMPRESSED_RGBA_BPTC_UNORM;
+            case ImageFormat::ETC2_RGB8:    return GL_COMPRESSED_RGB8_ETC2;
+            case ImageFormat::ETC2_RGBA8:   return GL_COMPRESSED_RGBA8_ETC2_EAC;
         }
 
         return 0;
     }
 
-    OpenGLTexture::OpenGLTexture(const std::filesystem::path& texture_filepath)
+    static bool _supported(ImageFormat format)
     {
-        int width, height, channels;
-        stbi_set_flip_vertically_on_load(true);
-        unsigned char* data = stbi_load(texture_filepath.string().c_str(), &width, &height, &channels, 0);
+        const auto& ext = OPENGL_EXTENSIONS;
 
-        _width = width;
-        _height = height;
-        
-        glGenTextures(1, &_id);
-        glBindTexture(GL_TEXTURE_2D, _id);
+        switch(format)
+        {
+            case ImageFormat::R8:
+            case ImageFormat::RGB8:
+            case ImageFormat::RGBA8:        return true;
+            case ImageFormat::BC1_RGB:
+            case ImageFormat::BC1:
+            case ImageFormat::BC3:          return ext.texture_compression_s3tc;
+            case ImageFormat::BC7:          return ext.texture_compression_bptc;
+            case ImageFormat::ETC2_RGB8:
+            case ImageFormat::ETC2_RGBA8:   return ext.texture_compression_etc2;
+        }
+
+        return false;
+    }
+
+    /// @brief bytes per 4x4 block of a compressed format
+    static u32 _block_size(ImageFormat format)
+    {
+        switch(format)
+        {
+            case ImageFormat::BC1_RGB:
+            case ImageFormat::BC1:
+            case ImageFormat::ETC2_RGB8:    return 8;
+            case ImageFormat::BC3:
+            case ImageFormat::BC7:
+            case ImageFormat::ETC2_RGBA8:   return 16;
+        }
+
+        return 0;
+    }
+
+    static u32 _pixel_format(ImageFormat format)
+    {
+        switch(format)
+        {
+            case ImageFormat::R8:       return GL_RED;
+            case ImageFormat::RGB8:     return GL_RGB;
+            case ImageFormat::RGBA8:    return GL_RGBA;
+        }
+
+        return 0;
+    }
+
+    /// @brief shared between the texture, the decode job and the upload queue. The worker only writes `image` and
+    /// then `decoded`; everything else is touched on the render thread alone.
+    struct TextureLoad
+    {
+        std::filesystem::path filepath;
+
+        /// @brief cleared if the texture is destroyed before its image arrives
+        OpenGLTexture* texture;
+
+        Image image;
+        std::atomic<bool> decoded = false;
+
+        /// @brief decided when the load starts; the decode job then also builds the CPU mip chain
+        bool stream = false;
+
+        /// @brief texture created from the image, swapped in for the placeholder; with the upload thread it's only
+        /// valid once `ticket` is complete
+        Ref<UploadTicket> ticket;
+        u32 uploaded_id = 0;
+    };
+
+    /// @brief ring of pixel unpack buffers; decoded images are copied into one and the texture is filled from it,
+    /// so the driver can transfer the pixels asynchronously instead of stalling on client memory
+    struct TextureUploadState
+    {
+        constexpr static const u32 STAGING_COUNT = 3;
 
-        switch (channels)
+        std::array<u32, STAGING_COUNT> buffers{};
+        std::array<size_t, STAGING_COUNT> sizes{};
+        std::array<GLsync, STAGING_COUNT> fences{};
+        u32 next = 0;
+
+        /// @brief in request order, so textures appear roughly in the order they were asked for
+        std::vector<Ref<TextureLoad>> loads;
+    };
+
+    static TextureUploadState UPLOAD_STATE;
+
+    /// @brief CPU copy of a streamed texture's whole mip chain, and which part of it is on the GPU
+    struct TextureStream
+    {
+        Image image;
+
+        /// @brief largest level currently on the GPU (lowest index); it and everything smaller are resident
+        u32 resident_base;
+
+        /// @brief level the streamer is moving the texture towards
+        u32 target_base;
+
+        /// @brief first level small enough to keep resident whatever the budget
+        u32 tail_base;
+
+        u64 last_used = 0;
+        u32 requested_size = 0;
+
+        size_t bytes_from(u32 base) const
         {
-            case 1: _format = GL_RED; break;
-            case 3: _format = GL_RGB; break;
-            case 4: _format = GL_RGBA; break;
+            size_t bytes = 0;
+            for (u32 level = base; level < image.levels.size(); level++)
+                bytes += image.levels[level].size;
+
+            return bytes;
         }
+    };
+
+    struct TextureStreamingState
+    {
+        /// @brief streamed textures arrive with mips up to this size, and never drop below them
+        constexpr static const u32 TAIL_SIZE = 64;
+
+        /// @brief frames since a texture was last bound before it falls back to its tail
+        constexpr static const u64 UNUSED_FRAMES = 120;
+
+        size_t budget = 0;
+        size_t texture_bytes = 0;
+        u32 constrained = 0;
 
-        if (data && _format != 0)
+        /// @brief counts process_uploads() calls; binds are stamped with it to tell how recently a texture was used
+        u64 frame = 0;
+
+        std::vector<OpenGLTexture*> textures;
+    };
+
+    static TextureStreamingState STREAMING;
+
+    static void _track_bytes(size_t& tracked, size_t bytes)
+    {
+        STREAMING.texture_bytes = STREAMING.texture_bytes - tracked + bytes;
+        tracked = bytes;
+    }
+
+    static u32 _bytes_per_pixel(ImageFormat format)
+    {
+        switch(format)
         {
-            std::cout << "Loaded: " << texture_filepath.string() << "\n";
-            glTexImage2D(GL_TEXTURE_2D, 0, _format, _width, _height, 0, _format, GL_UNSIGNED_BYTE, data);
-            glGenerateMipmap(GL_TEXTURE_2D);
-            stbi_image_free(data);
+            case ImageFormat::R8:       return 1;
+            // drivers pad 24 bit texels out to 32
+            case ImageFormat::RGB8:
+            case ImageFormat::RGBA8:    return 4;
         }
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        return 0;
+    }
+
+    static u32 _level_count(u32 width, u32 height)
+    {
+        u32 levels = 1;
+        for (u32 size = std::max(width, height); size > 1; size >>= 1)
+            levels++;
+
+        return levels;
+    }
+
+    static u32 _compressed_size(ImageFormat format, u32 width, u32 height)
+    {
+        return ((width + 3) / 4) * ((height + 3) / 4) * _block_size(format);
+    }
+
+    static size_t _storage_bytes(ImageFormat format, u32 width, u32 height, u32 layers, u32 levels)
+    {
+        size_t bytes = 0;
+        for (u32 level = 0; level < levels; level++)
+        {
+            u32 level_width = std::max(1u, width >> level);
+            u32 level_height = std::max(1u, height >> level);
+
+            if (is_compressed(format)) bytes += _compressed_size(format, level_width, level_height);
+            else bytes += (size_t)level_width * level_height * _bytes_per_pixel(format);
+        }
+
+        return bytes * layers;
+    }
+
+    /// @brief Allocate every level of the bound texture at once. With texture storage the result is immutable, so the
+    /// driver never has to re-validate or reallocate it; otherwise each level is allocated by hand.
+    static void _allocate(u32 target, ImageFormat format, u32 width, u32 height, u32 layers, u32 levels)
+    {
+        const auto& ext = OPENGL_EXTENSIONS;
+
+        if (ext.texture_storage)
+        {
+            if (target == GL_TEXTURE_2D_ARRAY) ext.TexStorage3D(target, levels, convert(format), width, height, layers);
+            else ext.TexStorage2D(target, levels, convert(format), width, height);
+            return;
+        }
+
+        for (u32 level = 0; level < levels; level++)
+        {
+            u32 level_width = std::max(1u, width >> level);
+            u32 level_height = std::max(1u, height >> level);
+
+            if (target == GL_TEXTURE_2D_ARRAY)
+            {
+                if (is_compressed(format)) glCompressedTexImage3D(target, level, convert(format), level_width, level_height, layers, 0, _compressed_size(format, level_width, level_height) * layers, nullptr);
+                else glTexImage3D(target, level, convert(format), level_width, level_height, layers, 0, _pixel_format(format), GL_UNSIGNED_BYTE, nullptr);
+            }
+            else
+            {
+                if (is_compressed(format)) glCompressedTexImage2D(target, level, convert(format), level_width, level_height, 0, _compressed_size(format, level_width, level_height), nullptr);
+                else glTexImage2D(target, level, convert(format), level_width, level_height, 0, _pixel_format(format), GL_UNSIGNED_BYTE, nullptr);
+            }
+        }
+
+        // immutable storage implies this; mutable textures are incomplete without it unless every level exists
+        glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    }
+
+    /// @brief levels _create_texture() gives `image`
+    static u32 _texture_levels(const Image& image, bool generate_mipmaps)
+    {
+        // compressed data can't have mips generated for it, so it only ever has the levels it was stored with
+        u32 stored_levels = image.levels.empty() ? 1 : (u32)image.levels.size();
+        bool generate = generate_mipmaps && stored_levels == 1 && !is_compressed(image.format);
+
+        return generate ? _level_count(image.width, image.height) : stored_levels;
+    }
+
+    /// @brief Create a texture holding `image`. `pixels` is the image's memory, or with a pixel unpack buffer bound,
+    /// the offset of its copy in that buffer. Mips are generated on the GPU unless the image brings its own chain.
+    static u32 _create_texture(const Image& image, const u8* pixels, bool generate_mipmaps)
+    {
+        auto at = [pixels](size_t offset) { return (const void*)((uintptr_t)pixels + offset); };
+
+        u32 stored_levels = image.levels.empty() ? 1 : (u32)image.levels.size();
+        u32 levels = _texture_levels(image, generate_mipmaps);
+        bool generate = levels > stored_levels;
+
+        u32 id;
+        glGenTextures(1, &id);
+        glBindTexture(GL_TEXTURE_2D, id);
+
+        _allocate(GL_TEXTURE_2D, image.format, image.width, image.height, 1, levels);
+
+        // rows of 1 and 3 channel images aren't 4 byte aligned
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        if (image.levels.empty())
+        {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width, image.height, _pixel_format(image.format), GL_UNSIGNED_BYTE, at(0));
+        }
+        else for (u32 i = 0; i < stored_levels; i++)
+        {
+            const auto& level = image.levels[i];
+            if (is_compressed(image.format))
+                glCompressedTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, level.width, level.height, convert(image.format), (GLsizei)level.size, at(level.offset));
+            else
+                glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, level.width, level.height, _pixel_format(image.format), GL_UNSIGNED_BYTE, at(level.offset));
+        }
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        if (generate) glGenerateMipmap(GL_TEXTURE_2D);
 
         glBindTexture(GL_TEXTURE_2D, 0);
+        return id;
+    }
+
+    /// @brief (re)define one level of the bound streamed texture from its CPU copy
+    static void _define_level(const Image& image, u32 level)
+    {
+        const auto& data = image.levels[level];
+        const u8* pixels = image.data() + data.offset;
+
+        if (is_compressed(image.format))
+        {
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, convert(image.format), data.width, data.height, 0, (GLsizei)data.size, pixels);
+        }
+        else
+        {
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexImage2D(GL_TEXTURE_2D, level, convert(image.format), data.width, data.height, 0, _pixel_format(image.format), GL_UNSIGNED_BYTE, pixels);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        }
+    }
+
+    /// @brief release one level of the bound streamed texture; it must already be outside BASE_LEVEL..MAX_LEVEL
+    static void _free_level(const Image& image, u32 level)
+    {
+        if (is_compressed(image.format)) glCompressedTexImage2D(GL_TEXTURE_2D, level, convert(image.format), 0, 0, 0, 0, nullptr);
+        else glTexImage2D(GL_TEXTURE_2D, level, convert(image.format), 0, 0, 0, _pixel_format(image.format), GL_UNSIGNED_BYTE, nullptr);
+    }
+
+    OpenGLTexture::OpenGLTexture(const std::filesystem::path& texture_filepath)
+        : OpenGLTexture(texture_filepath, nullptr)
+    {
+    }
+
+    OpenGLTexture::OpenGLTexture(const std::filesystem::path& texture_filepath, Ref<Image> image)
+        : _width(1), _height(1), _format(GL_RGBA)
+    {
+        // placeholder until the real image has been decoded and uploaded
+        const u8 grey[4] = { 128, 128, 128, 255 };
+
+        _spec.format = ImageFormat::RGBA8;
+
+        glGenTextures(1, &_id);
+        glBindTexture(GL_TEXTURE_2D, _id);
+        _allocate(GL_TEXTURE_2D, ImageFormat::RGBA8, 1, 1, 1, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+        _track_bytes(_bytes, 4);
+
+        _load = create_ref<TextureLoad>();
+        _load->filepath = texture_filepath;
+        _load->texture = this;
+        _load->stream = STREAMING.budget > 0;
+        UPLOAD_STATE.loads.push_back(_load);
+
+        if (image)
+        { // Texture::prepare already decoded it and built the mip chain, so there is nothing left for a worker to do
+            _load->image = std::move(*image);
+            _load->decoded.store(true, std::memory_order_release);
+            return;
+        }
+
+        Jobs::submit([load = _load]()
+        {
+            load->image = decode_image(load->filepath);
+            if (load->stream) generate_mip_chain(load->image);
+
+            load->decoded.store(true, std::memory_order_release);
+        });
     }
 
     OpenGLTexture::OpenGLTexture(const TextureSpec& spec)
         : _spec(spec), _width(spec.width), _height(spec.height)
     {
-        _format = convert(spec.format);
+        _format = _pixel_format(spec.format);
+
+        u32 levels = spec.generate_mipmaps ? _level_count(_width, _height) : 1;
 
         glGenTextures(1, &_id);
         glBindTexture(GL_TEXTURE_2D, _id);
-        
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        
+        // allocate up front so data() only has to fill it in
+        _allocate(GL_TEXTURE_2D, spec.format, _width, _height, 1, levels);
+
         glBindTexture(GL_TEXTURE_2D, 0);
+        _track_bytes(_bytes, _storage_bytes(spec.format, _width, _height, 1, levels));
+    }
+
+    OpenGLTexture::~OpenGLTexture()
+    {
+        // the decode may still be running; let the upload queue know there is nothing to upload into
+        if (_load) _load->texture = nullptr;
+        if (_stream) std::erase(STREAMING.textures, this);
+
+        glDeleteTextures(1, &_id);
+        _track_bytes(_bytes, 0);
     }
 
     void OpenGLTexture::bind(unsigned int slot) const
     {
+        bind(slot, _spec.sampler);
+    }
+
+    void OpenGLTexture::bind(unsigned int slot, const Sampler& sampler) const
+    {
+        if (_stream) _stream->last_used = STREAMING.frame;
+
         glActiveTexture(slot);
         glBindTexture(GL_TEXTURE_2D, _id);
+        OpenGLSamplerCache::bind(slot, sampler);
+    }
+
+    void OpenGLTexture::request_size(u32 pixels) const
+    {
+        if (_stream) _stream->requested_size = std::max(_stream->requested_size, pixels);
     }
 
     void OpenGLTexture::data(const void* data, u32 size)
     {
         glBindTexture(GL_TEXTURE_2D, _id);
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
         glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, _width, _height, _format, GL_UNSIGNED_BYTE, data);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        // levels below 0 are derived on the GPU every time level 0 changes
+        if (_spec.generate_mipmaps) glGenerateMipmap(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    void OpenGLTexture::process_uploads(size_t byte_budget)
+    {
+        auto& us = UPLOAD_STATE;
+
+        size_t uploaded = 0;
+        for (auto it = us.loads.begin(); it != us.loads.end();)
+        {
+            auto& load = **it;
+
+            // already with the upload thread; the new texture can only be used (or freed) once its fence signals
+            if (load.ticket)
+            {
+                if (!load.ticket->complete())
+                {
+                    ++it;
+                    continue;
+                }
+
+                if (load.texture) load.texture->_swap_in(load);
+                else glDeleteTextures(1, &load.uploaded_id);
+
+                it = us.loads.erase(it);
+                continue;
+            }
+
+            // texture was destroyed first; the result (or the job still producing it) is simply dropped
+            if (!load.texture)
+            {
+                it = us.loads.erase(it);
+                continue;
+            }
+
+            if (!load.decoded.load(std::memory_order_acquire))
+            {
+                ++it;
+                continue;
+            }
+
+            if (!load.image.valid() || !_supported(load.image.format))
+            {
+                if (load.image.valid()) std::cerr << "Texture format not supported by this GPU: " << load.filepath.string() << "\n";
+                else std::cerr << "Failed to load texture: " << load.filepath.string() << "\n";
+
+                load.texture->_load.reset();
+                it = us.loads.erase(it);
+                continue;
+            }
+
+            // streamed textures arrive with only their tail, which is small enough to define directly
+            if (load.stream && load.image.levels.size() > 1)
+            {
+                load.texture->_stream_in(load);
+                it = us.loads.erase(it);
+                continue;
+            }
+
+            if (OpenGLUploadThread::running())
+            {
+                _submit_upload(*it);
+                ++it;
+                continue;
+            }
+
+            // keep uploads per frame bounded, but never starve a texture bigger than the whole budget
+            size_t size = load.image.size();
+            if (uploaded > 0 && uploaded + size > byte_budget) break;
+
+            if (!_upload(load)) break;
+            uploaded += size;
+
+            load.texture->_swap_in(load);
+            it = us.loads.erase(it);
+        }
+
+        _update_streaming(byte_budget > uploaded ? byte_budget - uploaded : 0);
+    }
+
+    void OpenGLTexture::streaming_budget(size_t bytes)
+    {
+        STREAMING.budget = bytes;
+    }
+
+    TextureStreamingStats OpenGLTexture::streaming_stats()
+    {
+        TextureStreamingStats stats;
+        stats.texture_bytes = STREAMING.texture_bytes;
+        stats.budget = STREAMING.budget;
+        stats.streamed_textures = (u32)STREAMING.textures.size();
+        stats.constrained_textures = STREAMING.constrained;
+        return stats;
+    }
+
+    void OpenGLTexture::_stream_in(TextureLoad& load)
+    {
+        auto stream = create_scope<TextureStream>();
+        stream->image = std::move(load.image);
+
+        const auto& image = stream->image;
+        u32 levels = (u32)image.levels.size();
+
+        u32 tail = 0;
+        while (tail + 1 < levels && std::max(image.levels[tail].width, image.levels[tail].height) > TextureStreamingState::TAIL_SIZE)
+            tail++;
+
+        stream->resident_base = tail;
+        stream->target_base = tail;
+        stream->tail_base = tail;
+        stream->last_used = STREAMING.frame;
+
+        glDeleteTextures(1, &_id);
+        glGenTextures(1, &_id);
+        glBindTexture(GL_TEXTURE_2D, _id);
+
+        // deliberately mutable storage: residency changes by defining and releasing single levels, which immutable
+        // textures don't allow
+        for (u32 level = tail; level < levels; level++)
+            _define_level(image, level);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, tail);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        _image_info(image);
+        _track_bytes(_bytes, stream->bytes_from(tail));
+
+        _stream = std::move(stream);
+        STREAMING.textures.push_back(this);
+
+        std::cout << "Streaming: " << load.filepath.string() << "\n";
+        _load.reset();
+    }
+
+    void OpenGLTexture::_update_streaming(size_t byte_budget)
+    {
+        auto& st = STREAMING;
+        u64 frame = st.frame++;
+
+        if (st.textures.empty()) return;
+
+        // what every texture would like resident: full detail if bound recently, less if it's only drawn small,
+        // just its tail if it hasn't been bound for a while
+        size_t wanted_bytes = st.texture_bytes;
+        for (auto* texture : st.textures)
+        {
+            auto& stream = *texture->_stream;
+            wanted_bytes -= texture->_bytes;
+
+            if (frame - stream.last_used > TextureStreamingState::UNUSED_FRAMES)
+            {
+                stream.target_base = stream.tail_base;
+            }
+            else if (stream.requested_size > 0)
+            { // the smallest level that still covers the requested size
+                u32 base = 0;
+                while (base < stream.tail_base && std::max(stream.image.levels[base + 1].width, stream.image.levels[base + 1].height) >= stream.requested_size)
+                    base++;
+
+                stream.target_base = base;
+            }
+            else stream.target_base = 0;
+
+            stream.requested_size = 0;
+            wanted_bytes += stream.bytes_from(stream.target_base);
+        }
+
+        // least recently used first, then largest; recency decides who gives up detail to fit the budget
+        std::vector<OpenGLTexture*> order = st.textures;
+        std::sort(order.begin(), order.end(), [](const OpenGLTexture* a, const OpenGLTexture* b)
+        {
+            if (a->_stream->last_used != b->_stream->last_used) return a->_stream->last_used < b->_stream->last_used;
+            return a->_bytes > b->_bytes;
+        });
+
+        st.constrained = 0;
+        for (auto* texture : order)
+        {
+            if (st.budget == 0 || wanted_bytes <= st.budget) break;
+
+            auto& stream = *texture->_stream;
+            if (stream.target_base < stream.tail_base) st.constrained++;
+
+            while (wanted_bytes > st.budget && stream.target_base < stream.tail_base)
+                wanted_bytes -= stream.image.levels[stream.target_base++].size;
+        }
+
+        // dropping detail is free and immediate
+        for (auto* texture : st.textures)
+        {
+            auto& stream = *texture->_stream;
+            if (stream.target_base <= stream.resident_base) continue;
+
+            glBindTexture(GL_TEXTURE_2D, texture->_id);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, stream.target_base);
+            for (u32 level = stream.resident_base; level < stream.target_base; level++)
+                _free_level(stream.image, level);
+
+            stream.resident_base = stream.target_base;
+            _track_bytes(texture->_bytes, stream.bytes_from(stream.resident_base));
+        }
+
+        // raising it costs an upload, so it goes one level per texture per frame within the upload budget, most
+        // recently used first
+        size_t uploaded = 0;
+        for (auto it = order.rbegin(); it != order.rend(); ++it)
+        {
+            auto* texture = *it;
+            auto& stream = *texture->_stream;
+            if (stream.target_base >= stream.resident_base) continue;
+
+            u32 level = stream.resident_base - 1;
+            size_t size = stream.image.levels[level].size;
+            if (uploaded > 0 && uploaded + size > byte_budget) break;
+
+            glBindTexture(GL_TEXTURE_2D, texture->_id);
+            _define_level(stream.image, level);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+
+            stream.resident_base = level;
+            _track_bytes(texture->_bytes, stream.bytes_from(stream.resident_base));
+            uploaded += size;
+        }
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    void OpenGLTexture::_image_info(const Image& image)
+    {
+        _width = image.width;
+        _height = image.height;
+        _format = _pixel_format(image.format);
+        _spec.width = image.width;
+        _spec.height = image.height;
+        _spec.format = image.format;
+    }
+
+    bool OpenGLTexture::_upload(TextureLoad& load)
+    {
+        auto& us = UPLOAD_STATE;
+        u32 slot = us.next;
+
+        // the previous upload from this buffer may still be in flight; try again next frame rather than wait
+        if (us.fences[slot])
+        {
+            if (glClientWaitSync(us.fences[slot], 0, 0) == GL_TIMEOUT_EXPIRED) return false;
+
+            glDeleteSync(us.fences[slot]);
+            us.fences[slot] = nullptr;
+        }
+
+        const auto& image = load.image;
+        size_t size = image.size();
+
+        if (!us.buffers[slot]) glGenBuffers(1, &us.buffers[slot]);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, us.buffers[slot]);
+        if (us.sizes[slot] < size)
+        {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+            us.sizes[slot] = size;
+        }
+
+        void* dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        std::memcpy(dst, image.data(), size);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        // storage is immutable, so the image goes into a new texture that replaces the placeholder
+        load.uploaded_id = _create_texture(image, nullptr, load.texture->_spec.generate_mipmaps);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        us.fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        us.next = (slot + 1) % TextureUploadState::STAGING_COUNT;
+
+        return true;
+    }
+
+    void OpenGLTexture::_submit_upload(const Ref<TextureLoad>& load)
+    {
+        // the job mustn't touch the texture itself, it may be destroyed on this thread meanwhile
+        bool generate_mipmaps = load->texture->_spec.generate_mipmaps;
+
+        load->ticket = OpenGLUploadThread::submit([load, generate_mipmaps]()
+        {
+            load->uploaded_id = _create_texture(load->image, load->image.data(), generate_mipmaps);
+        });
+    }
+
+    void OpenGLTexture::_swap_in(TextureLoad& load)
+    {
+        glDeleteTextures(1, &_id);
+        _id = load.uploaded_id;
+        _image_info(load.image);
+
+        u32 levels = _texture_levels(load.image, _spec.generate_mipmaps);
+        _track_bytes(_bytes, _storage_bytes(load.image.format, load.image.width, load.image.height, 1, levels));
+
+        std::cout << "Loaded: " << load.filepath.string() << "\n";
+        _load.reset();
+    }
+
+    OpenGLTexture2DArray::OpenGLTexture2DArray(const TextureArraySpec& spec)
+        : _spec(spec)
+    {
+        _format = _pixel_format(spec.format);
+
+        if (_spec.levels == 0) _spec.levels = _level_count(_spec.width, _spec.height);
+
+        glGenTextures(1, &_id);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, _id);
+
+        // allocate every level up front so data() only has to fill layers in
+        _allocate(GL_TEXTURE_2D_ARRAY, _spec.format, _spec.width, _spec.height, _spec.layers, _spec.levels);
+        _track_bytes(_bytes, _storage_bytes(_spec.format, _spec.width, _spec.height, _spec.layers, _spec.levels));
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+
+    OpenGLTexture2DArray::~OpenGLTexture2DArray()
+    {
+        glDeleteTextures(1, &_id);
+        _track_bytes(_bytes, 0);
+    }
+
+    void OpenGLTexture2DArray::bind(unsigned int slot) const
+    {
+        bind(slot, _spec.sampler);
+    }
+
+    void OpenGLTexture2DArray::bind(unsigned int slot, const Sampler& sampler) const
+    {
+        glActiveTexture(slot);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, _id);
+        OpenGLSamplerCache::bind(slot, sampler);
+    }
+
+    void OpenGLTexture2DArray::data(u32 layer, const void* data, u32 size, u32 level)
+    {
+        u32 width = std::max(1u, _spec.width >> level);
+        u32 height = std::max(1u, _spec.height >> level);
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, _id);
+
+        if (is_compressed(_spec.format))
+        {
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1, convert(_spec.format), size, data);
+        }
+        else
+        {
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1, _format, GL_UNSIGNED_BYTE, data);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        }
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+
+    void OpenGLTexture2DArray::generate_mipmaps()
+    {
+        if (_spec.levels <= 1 || is_compressed(_spec.format)) return;
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, _id);
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
     }
 } // namespace inx
\ No newline at end of file
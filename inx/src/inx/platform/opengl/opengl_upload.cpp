@@ -0,0 +1,158 @@
+#include "../opengl.h"
+
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include <glad/glad.h>
+#include <SDL3/SDL_error.h>
+#include <SDL3/SDL_video.h>
+
+namespace inx
+{
+    struct UploadJob
+    {
+        std::function<void()> job;
+        Ref<UploadTicket> ticket;
+    };
+
+    struct UploadThreadState
+    {
+        SDL_Window* window = nullptr;
+        SDL_GLContext context = nullptr;
+
+        std::thread thread;
+        std::deque<UploadJob> queue;
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        bool running = false;
+    };
+
+    static UploadThreadState UPLOAD_THREAD;
+
+    bool UploadTicket::complete()
+    {
+        if (_complete) return true;
+        if (!_submitted.load(std::memory_order_acquire)) return false;
+
+        if (glClientWaitSync((GLsync)_fence, 0, 0) == GL_TIMEOUT_EXPIRED) return false;
+
+        glDeleteSync((GLsync)_fence);
+        _fence = nullptr;
+        _complete = true;
+        return true;
+    }
+
+    void UploadTicket::wait()
+    {
+        if (_complete) return;
+
+        _submitted.wait(false, std::memory_order_acquire);
+
+        glClientWaitSync((GLsync)_fence, 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync((GLsync)_fence);
+        _fence = nullptr;
+        _complete = true;
+    }
+
+    void OpenGLUploadThread::_run()
+    {
+        auto& ut = UPLOAD_THREAD;
+
+        SDL_GL_MakeCurrent(ut.window, ut.context);
+
+        for (;;)
+        {
+            UploadJob upload;
+            {
+                std::unique_lock lock(ut.mutex);
+                ut.wake.wait(lock, [&ut]() { return !ut.running || !ut.queue.empty(); });
+
+                // drain before stopping so no ticket is left waiting forever
+                if (ut.queue.empty()) break;
+
+                upload = std::move(ut.queue.front());
+                ut.queue.pop_front();
+            }
+
+            upload.job();
+
+            // the fence covers everything the job issued; flush so it's guaranteed to signal without this context
+            // ever doing more work
+            upload.ticket->_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            glFlush();
+
+            upload.ticket->_submitted.store(true, std::memory_order_release);
+            upload.ticket->_submitted.notify_all();
+        }
+
+        SDL_GL_MakeCurrent(ut.window, nullptr);
+    }
+
+    bool OpenGLUploadThread::start(SDL_Window* window)
+    {
+        auto& ut = UPLOAD_THREAD;
+
+        if (ut.running) return true;
+
+        // creating a context makes it current, so put the render context back afterwards
+        auto render_context = SDL_GL_GetCurrentContext();
+
+        SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+        ut.context = SDL_GL_CreateContext(window);
+        SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+
+        SDL_GL_MakeCurrent(window, render_context);
+
+        if (!ut.context)
+        {
+            std::cerr << "Could not create upload context, uploading on the render thread: " << SDL_GetError() << "\n";
+            return false;
+        }
+
+        ut.window = window;
+        ut.running = true;
+        ut.thread = std::thread(_run);
+
+        return true;
+    }
+
+    void OpenGLUploadThread::stop()
+    {
+        auto& ut = UPLOAD_THREAD;
+
+        {
+            std::lock_guard lock(ut.mutex);
+            if (!ut.running) return;
+            ut.running = false;
+        }
+        ut.wake.notify_all();
+        ut.thread.join();
+
+        SDL_GL_DestroyContext(ut.context);
+        ut.context = nullptr;
+        ut.window = nullptr;
+    }
+
+    bool OpenGLUploadThread::running()
+    {
+        return UPLOAD_THREAD.running;
+    }
+
+    Ref<UploadTicket> OpenGLUploadThread::submit(std::function<void()> job)
+    {
+        auto& ut = UPLOAD_THREAD;
+
+        auto ticket = create_ref<UploadTicket>();
+        {
+            std::lock_guard lock(ut.mutex);
+            ut.queue.push_back({ std::move(job), ticket });
+        }
+        ut.wake.notify_one();
+
+        return ticket;
+    }
+} // namespace inx
\ No newline at end of file
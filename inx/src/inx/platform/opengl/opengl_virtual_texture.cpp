@@ -0,0 +1,476 @@
+#include "../opengl.h"
+#include "opengl_extensions.h"
+#include "../../core.h"
+#include "../../resources/resources_internal.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <iostream>
+#include <unordered_set>
+
+#include <glad/glad.h>
+
+namespace inx
+{
+    struct VirtualTextureSource
+    {
+        std::filesystem::path filepath;
+
+        /// @brief whole image with its CPU mip chain; pages are cut from it on worker threads
+        Image image;
+        std::atomic<bool> decoded = false;
+    };
+
+    struct VirtualPageLoad
+    {
+        u32 key;
+        std::vector<u8> pixels;
+        std::atomic<bool> done = false;
+    };
+
+    // pages are at most 256 across, so a page's position and mip fit in one integer, and in one RGBA8 texel
+
+    static u32 _page_key(u32 x, u32 y, u32 mip)
+    {
+        return (mip << 16) | (y << 8) | x;
+    }
+
+    static u32 _page_x(u32 key) { return key & 0xff; }
+    static u32 _page_y(u32 key) { return (key >> 8) & 0xff; }
+    static u32 _page_mip(u32 key) { return key >> 16; }
+
+    static const Sampler CACHE_SAMPLER = {
+        .mip_filter = MipFilter::None, .wrap_u = TextureWrap::ClampToEdge, .wrap_v = TextureWrap::ClampToEdge };
+
+    static const Sampler INDIRECTION_SAMPLER = {
+        .min_filter = TextureFilter::Nearest, .mag_filter = TextureFilter::Nearest, .mip_filter = MipFilter::Nearest,
+        .wrap_u = TextureWrap::ClampToEdge, .wrap_v = TextureWrap::ClampToEdge };
+
+    /// @brief Copy one page plus its border out of the source image as RGBA8, clamping at the image's edges
+    static void _cut_page(const Image& image, u32 key, const VirtualTextureSpec& spec, std::vector<u8>& pixels)
+    {
+        const auto& level = image.levels[_page_mip(key)];
+        const u8* src = image.data() + level.offset;
+
+        const i64 tile = spec.page_size + 2 * spec.border;
+        const i64 x0 = (i64)_page_x(key) * spec.page_size - spec.border;
+        const i64 y0 = (i64)_page_y(key) * spec.page_size - spec.border;
+
+        pixels.resize(tile * tile * 4);
+        u8* dst = pixels.data();
+
+        for (i64 ty = 0; ty < tile; ty++)
+        {
+            i64 sy = std::clamp<i64>(y0 + ty, 0, level.height - 1);
+            for (i64 tx = 0; tx < tile; tx++, dst += 4)
+            {
+                i64 sx = std::clamp<i64>(x0 + tx, 0, level.width - 1);
+                const u8* texel = src + (sy * level.width + sx) * image.channels;
+
+                switch(image.channels)
+                {
+                    case 1:     dst[0] = dst[1] = dst[2] = texel[0]; dst[3] = 255; break;
+                    case 3:     dst[0] = texel[0]; dst[1] = texel[1]; dst[2] = texel[2]; dst[3] = 255; break;
+                    default:    dst[0] = texel[0]; dst[1] = texel[1]; dst[2] = texel[2]; dst[3] = texel[3]; break;
+                }
+            }
+        }
+    }
+
+    static void _allocate_rgba8(u32 width, u32 height, u32 levels)
+    {
+        const auto& ext = OPENGL_EXTENSIONS;
+        if (ext.texture_storage)
+        {
+            ext.TexStorage2D(GL_TEXTURE_2D, levels, GL_RGBA8, width, height);
+            return;
+        }
+
+        for (u32 level = 0; level < levels; level++)
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, std::max(1u, width >> level), std::max(1u, height >> level), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    }
+
+    OpenGLVirtualTexture::OpenGLVirtualTexture(const std::filesystem::path& image_filepath, const VirtualTextureSpec& spec)
+        : _spec(spec)
+    {
+        if (!std::has_single_bit(spec.page_size) || spec.cache_pages == 0 || spec.cache_pages > 256 || spec.feedback_scale == 0)
+        {
+            std::cerr << "Invalid virtual texture spec for " << image_filepath.string() << "\n";
+            throw std::runtime_error("Invalid virtual texture spec: " + image_filepath.string());
+        }
+
+        _source = create_ref<VirtualTextureSource>();
+        _source->filepath = image_filepath;
+
+        Jobs::submit([source = _source]()
+        {
+            source->image = decode_image(source->filepath);
+            generate_mip_chain(source->image);
+
+            source->decoded.store(true, std::memory_order_release);
+        });
+    }
+
+    OpenGLVirtualTexture::~OpenGLVirtualTexture()
+    {
+        // page loads still running hold their own references to the source, so they can finish on their own
+
+        for (auto& readback : _readbacks)
+        {
+            if (readback.fence) glDeleteSync((GLsync)readback.fence);
+            if (readback.buffer) glDeleteBuffers(1, &readback.buffer);
+        }
+
+        if (_feedback_fbo) glDeleteFramebuffers(1, &_feedback_fbo);
+        if (_feedback_colour) glDeleteRenderbuffers(1, &_feedback_colour);
+        if (_feedback_depth) glDeleteRenderbuffers(1, &_feedback_depth);
+
+        if (_cache_id) glDeleteTextures(1, &_cache_id);
+        if (_indirection_id) glDeleteTextures(1, &_indirection_id);
+    }
+
+    void OpenGLVirtualTexture::bind(const Shader& shader, unsigned int cache_slot, unsigned int indirection_slot) const
+    {
+        glActiveTexture(cache_slot);
+        glBindTexture(GL_TEXTURE_2D, _cache_id);
+        OpenGLSamplerCache::bind(cache_slot, CACHE_SAMPLER);
+
+        glActiveTexture(indirection_slot);
+        glBindTexture(GL_TEXTURE_2D, _indirection_id);
+        OpenGLSamplerCache::bind(indirection_slot, INDIRECTION_SAMPLER);
+
+        shader.set_int("u_vt_cache", cache_slot - GL_TEXTURE0);
+        shader.set_int("u_vt_indirection", indirection_slot - GL_TEXTURE0);
+
+        // the feedback target is smaller than the screen, so its derivatives pick mips that much too coarse
+        float lod_bias = _in_feedback ? -std::log2((float)_spec.feedback_scale) : 0.f;
+        float tile = (float)(_spec.page_size + 2 * _spec.border);
+
+        shader.set_vec3("u_vt_page", glm::vec3((float)(_pages * _spec.page_size), (float)_spec.page_size, (float)_spec.border));
+        shader.set_vec3("u_vt_cache_info", glm::vec3(tile * _spec.cache_pages, (float)(_mips ? _mips - 1 : 0), lod_bias));
+    }
+
+    void OpenGLVirtualTexture::begin_feedback(i32 screen_width, i32 screen_height)
+    {
+        _screen_width = screen_width;
+        _screen_height = screen_height;
+
+        i32 width = std::max(1, screen_width / (i32)_spec.feedback_scale);
+        i32 height = std::max(1, screen_height / (i32)_spec.feedback_scale);
+
+        if (!_feedback_fbo)
+        {
+            glGenFramebuffers(1, &_feedback_fbo);
+            glGenRenderbuffers(1, &_feedback_colour);
+            glGenRenderbuffers(1, &_feedback_depth);
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, _feedback_fbo);
+
+        if (width != _feedback_width || height != _feedback_height)
+        {
+            glBindRenderbuffer(GL_RENDERBUFFER, _feedback_colour);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+            glBindRenderbuffer(GL_RENDERBUFFER, _feedback_depth);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+            glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _feedback_colour);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _feedback_depth);
+
+            _feedback_width = width;
+            _feedback_height = height;
+        }
+
+        glViewport(0, 0, width, height);
+
+        // alpha 0 marks texels nothing virtual was drawn to
+        GLfloat clear_colour[4];
+        glGetFloatv(GL_COLOR_CLEAR_VALUE, clear_colour);
+        glClearColor(0.f, 0.f, 0.f, 0.f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glClearColor(clear_colour[0], clear_colour[1], clear_colour[2], clear_colour[3]);
+
+        _in_feedback = true;
+    }
+
+    void OpenGLVirtualTexture::end_feedback()
+    {
+        auto& readback = _readbacks[_next_readback];
+
+        // every read back still in flight means the GPU is a few frames behind; skip this frame's feedback rather
+        // than wait for it
+        if (!readback.fence)
+        {
+            size_t size = (size_t)_feedback_width * _feedback_height * 4;
+
+            if (!readback.buffer) glGenBuffers(1, &readback.buffer);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+            if (readback.size < size)
+            {
+                glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+                readback.size = size;
+            }
+
+            glReadPixels(0, 0, _feedback_width, _feedback_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+            readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            readback.width = _feedback_width;
+            readback.height = _feedback_height;
+
+            _next_readback = (_next_readback + 1) % READBACK_COUNT;
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, _screen_width, _screen_height);
+
+        _in_feedback = false;
+    }
+
+    void OpenGLVirtualTexture::update()
+    {
+        if (!_cache_id)
+        {
+            if (!_source->decoded.load(std::memory_order_acquire)) return;
+            _create();
+        }
+
+        _frame++;
+
+        // oldest first; read backs complete in the order they were issued
+        for (u32 i = 0; i < READBACK_COUNT; i++)
+        {
+            auto& readback = _readbacks[(_next_readback + i) % READBACK_COUNT];
+            if (!readback.fence) continue;
+            if (glClientWaitSync((GLsync)readback.fence, 0, 0) == GL_TIMEOUT_EXPIRED) break;
+
+            glDeleteSync((GLsync)readback.fence);
+            readback.fence = nullptr;
+
+            _read_feedback(readback);
+        }
+
+        for (auto it = _loading.begin(); it != _loading.end();)
+        {
+            auto& load = *it->second;
+            if (!load.done.load(std::memory_order_acquire))
+            {
+                ++it;
+                continue;
+            }
+
+            _place(load.key, load.pixels);
+            it = _loading.erase(it);
+        }
+
+        while (!_wanted.empty() && _loading.size() < _spec.max_page_loads)
+        {
+            u32 key = _wanted.back();
+            _wanted.pop_back();
+
+            if (_resident.contains(key) || _loading.contains(key)) continue;
+
+            auto load = create_ref<VirtualPageLoad>();
+            load->key = key;
+            _loading[key] = load;
+
+            Jobs::submit([source = _source, load, spec = _spec]()
+            {
+                _cut_page(source->image, load->key, spec, load->pixels);
+                load->done.store(true, std::memory_order_release);
+            });
+        }
+
+        if (_page_table_dirty) _write_page_table();
+    }
+
+    VirtualTextureStats OpenGLVirtualTexture::stats() const
+    {
+        VirtualTextureStats stats;
+        stats.resident_pages = (u32)_resident.size();
+        stats.cache_pages = (u32)_cache.size();
+        stats.requested_pages = _requested_pages;
+        stats.pending_loads = (u32)_loading.size();
+        stats.dropped_loads = _dropped_loads;
+        stats.evictions = _evictions;
+        return stats;
+    }
+
+    void OpenGLVirtualTexture::_create()
+    {
+        const auto& image = _source->image;
+        const std::string filepath = _source->filepath.string();
+
+        if (!image.valid() || is_compressed(image.format))
+        {
+            std::cerr << "Could not load virtual texture: " << filepath << "\n";
+            throw std::runtime_error("Could not load virtual texture: " + filepath);
+        }
+
+        if (image.width != image.height || !std::has_single_bit(image.width) || image.width < _spec.page_size || image.width / _spec.page_size > 256)
+        {
+            std::cerr << "Virtual texture " << filepath << " is " << image.width << "x" << image.height
+                      << "; it has to be square, a power of two and between 1 and 256 pages across\n";
+            throw std::runtime_error("Unsupported virtual texture size: " + filepath);
+        }
+
+        _pages = image.width / _spec.page_size;
+        _mips = std::bit_width(_pages);
+
+        u32 tile = _spec.page_size + 2 * _spec.border;
+
+        glGenTextures(1, &_cache_id);
+        glBindTexture(GL_TEXTURE_2D, _cache_id);
+        _allocate_rgba8(tile * _spec.cache_pages, tile * _spec.cache_pages, 1);
+
+        glGenTextures(1, &_indirection_id);
+        glBindTexture(GL_TEXTURE_2D, _indirection_id);
+        _allocate_rgba8(_pages, _pages, _mips);
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        _cache.resize(_spec.cache_pages * _spec.cache_pages);
+
+        _page_table.resize(_mips);
+        for (u32 mip = 0; mip < _mips; mip++)
+            _page_table[mip].resize((size_t)(_pages >> mip) * (_pages >> mip) * 4);
+
+        // the page covering the whole image is always resident, so every lookup has something to fall back to
+        u32 root = _page_key(0, 0, _mips - 1);
+        std::vector<u8> pixels;
+        _cut_page(image, root, _spec, pixels);
+        _place(root, pixels);
+        _cache[_resident[root]].last_used = ~0ull;
+
+        _write_page_table();
+
+        std::cout << "Loaded: " << filepath << " (" << _pages << "x" << _pages << " virtual pages)\n";
+    }
+
+    void OpenGLVirtualTexture::_read_feedback(Readback& readback)
+    {
+        size_t size = (size_t)readback.width * readback.height * 4;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+        const u8* texels = (const u8*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+
+        // a needed page's ancestors are needed too: they're what's sampled until it arrives
+        std::unordered_set<u32> keys;
+        for (size_t i = 0; texels && i < size; i += 4)
+        {
+            if (texels[i + 3] == 0) continue;
+
+            u32 x = texels[i], y = texels[i + 1], mip = texels[i + 2];
+            if (mip >= _mips || x >= (_pages >> mip) || y >= (_pages >> mip)) continue;
+
+            for (; mip < _mips; mip++, x /= 2, y /= 2)
+                if (!keys.insert(_page_key(x, y, mip)).second) break;
+        }
+
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        _wanted.clear();
+        for (u32 key : keys)
+        {
+            auto it = _resident.find(key);
+            if (it != _resident.end())
+            {
+                auto& page = _cache[it->second];
+                page.last_used = std::max(page.last_used, _frame);
+            }
+            else if (!_loading.contains(key)) _wanted.push_back(key);
+        }
+
+        // coarse pages last so they're popped first; a coarse page improves a much larger area than a fine one
+        std::sort(_wanted.begin(), _wanted.end(), [](u32 a, u32 b) { return _page_mip(a) < _page_mip(b); });
+
+        _requested_pages = (u32)keys.size();
+    }
+
+    void OpenGLVirtualTexture::_place(u32 key, const std::vector<u8>& pixels)
+    {
+        // a free cache page, or else the least recently needed one that wasn't needed this frame
+        u32 slot = NO_PAGE;
+        for (u32 i = 0; i < _cache.size(); i++)
+        {
+            const auto& page = _cache[i];
+            if (page.key == NO_PAGE)
+            {
+                slot = i;
+                break;
+            }
+
+            if (page.last_used < _frame && (slot == NO_PAGE || page.last_used < _cache[slot].last_used)) slot = i;
+        }
+
+        if (slot == NO_PAGE)
+        {
+            _dropped_loads++;
+            return;
+        }
+
+        auto& page = _cache[slot];
+        if (page.key != NO_PAGE)
+        {
+            _resident.erase(page.key);
+            _evictions++;
+        }
+
+        u32 tile = _spec.page_size + 2 * _spec.border;
+
+        glBindTexture(GL_TEXTURE_2D, _cache_id);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, (slot % _spec.cache_pages) * tile, (slot / _spec.cache_pages) * tile, tile, tile, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        page.key = key;
+        page.last_used = _frame;
+        _resident[key] = slot;
+
+        _page_table_dirty = true;
+    }
+
+    void OpenGLVirtualTexture::_write_page_table()
+    {
+        glBindTexture(GL_TEXTURE_2D, _indirection_id);
+
+        // coarsest first, so a missing page can take its parent's already resolved entry
+        for (u32 mip = _mips; mip-- > 0;)
+        {
+            u32 pages = _pages >> mip;
+            auto& level = _page_table[mip];
+
+            for (u32 y = 0; y < pages; y++)
+            {
+                for (u32 x = 0; x < pages; x++)
+                {
+                    u8* entry = &level[(y * pages + x) * 4];
+
+                    auto it = _resident.find(_page_key(x, y, mip));
+                    if (it != _resident.end())
+                    {
+                        entry[0] = (u8)(it->second % _spec.cache_pages);
+                        entry[1] = (u8)(it->second / _spec.cache_pages);
+                        entry[2] = (u8)mip;
+                        entry[3] = 255;
+                    }
+                    else if (mip + 1 < _mips)
+                    {
+                        const u8* parent = &_page_table[mip + 1][((y / 2) * (pages / 2) + x / 2) * 4];
+                        std::copy(parent, parent + 4, entry);
+                    }
+                }
+            }
+
+            glTexSubImage2D(GL_TEXTURE_2D, mip, 0, 0, pages, pages, GL_RGBA, GL_UNSIGNED_BYTE, level.data());
+        }
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+        _page_table_dirty = false;
+    }
+} // namespace inx
@@ -1,6 +1,7 @@
 #ifndef __INX_RENDERER_H__
 #define __INX_RENDERER_H__
 
+#include <cstddef>
 #include <vector>
 #include <string>
 
@@ -9,8 +10,17 @@
 #include "types.h"
 #include "resources.h"
 
+struct SDL_Window;
+
 namespace inx
 {
+    struct VertexArray;
+
+    enum class BlendMode
+    {
+        None = 0, Alpha, Additive,
+    };
+
     namespace render_api
     {
         void init();
@@ -18,6 +28,27 @@ namespace inx
         void viewport(i32 width, i32 height);
         void clear_colour(const glm::vec3& colour);
         void clear();
+
+        void blend(BlendMode mode);
+
+        /// @brief texture units a fragment shader can sample from; GL 4.1 only guarantees 16
+        u32 max_texture_units();
+
+        /// @brief Register a shader/vertex layout/blend (and optionally texture) combination that will be drawn during
+        /// gameplay, so warm_up() can make the driver do its deferred work for it ahead of time
+        void register_warm_up(const Shader& shader, const Ref<VertexArray>& vertex_array, BlendMode blend = BlendMode::None, const Texture* texture = nullptr);
+
+        /// @brief Issue a tiny off-screen draw for every registered combination and wait for the GPU to finish them.
+        /// Call at the end of loading; it moves first-use hitches from the first gameplay frames into the load.
+        void warm_up();
+
+        /// @brief Start a thread with its own shared GL context that takes over texture uploads and shader links, so
+        /// the render thread only draws. Optional; call after init() with the window's context current.
+        /// @return false if the shared context couldn't be created, in which case everything stays on this thread
+        bool start_upload_thread(SDL_Window* window);
+
+        /// @brief finish outstanding upload jobs and destroy the shared context; call before destroying the main one
+        void stop_upload_thread();
     } // namespace render_api
 
     namespace render2d
@@ -25,11 +56,29 @@ namespace inx
         void init(ResourceManager& manager);
         void shutdown();
 
+        /// @brief Texture slots one batch can bind, sized from render_api::max_texture_units() at init. The quad shader
+        /// must be compiled with it as MAX_TEXTURE_SLOTS and its u_textures set to units 0 to count - 1.
+        u32 texture_slot_count();
+
+        /// @brief unit the batch's texture array is bound to, for the quad shader's u_layers
+        u32 array_texture_unit();
+
+        /// @brief register the batch layout drawn with `shader` for render_api::warm_up()
+        void register_warm_up(const Shader& shader);
+
         void begin_batch();
         void end_batch();
         void flush();
 
         void draw_quad(const glm::vec3& position, const glm::vec2& size, const glm::vec4& colour);
+
+        /// @brief Draw an atlas region; every region on the same page shares a texture slot, so whole sprite sets
+        /// batch together
+        void draw_quad(const glm::vec3& position, const glm::vec2& size, const AtlasRegion& region, const glm::vec4& tint = glm::vec4(1.f));
+
+        /// @brief Draw a texture array layer. Any number of layers of the same array batch together; only switching
+        /// to a different array starts a new batch.
+        void draw_quad(const glm::vec3& position, const glm::vec2& size, const ArrayLayer& layer, const glm::vec4& tint = glm::vec4(1.f));
     } // namespace render2d
 
     enum BufferElementDataType
@@ -97,6 +146,172 @@ namespace inx
         static Ref<IndexBuffer> create(u32* indices, u32 count);
     };
 
+    /// @brief Fixed binding points for uniform blocks shared between shaders. When a shader is linked, any uniform block
+    /// whose name matches uniform_block_name() is bound to the corresponding point.
+    enum class UniformBlock : u32
+    {
+        Camera = 0,
+        Lights = 1,
+        Object = 2,
+
+        COUNT
+    };
+
+    constexpr const char* uniform_block_name(UniformBlock block)
+    {
+        switch (block)
+        {
+            case UniformBlock::Camera:  return "Camera";
+            case UniformBlock::Lights:  return "Lights";
+            case UniformBlock::Object:  return "Object";
+        }
+
+        return "";
+    }
+
+    struct UniformBuffer
+    {
+        virtual ~UniformBuffer() = default;
+
+        /// @brief Bind the whole buffer to its uniform block binding point
+        virtual void bind() const = 0;
+
+        virtual void data(const void* data, u32 size, u32 offset = 0) = 0;
+
+        template<typename T>
+        void data(const T& block) { data(&block, sizeof(T)); }
+
+        static Ref<UniformBuffer> create(u32 size, UniformBlock binding);
+    };
+
+    /// @brief Frame-scoped ring of uniform memory for per-draw constants. push() copies a block into the ring and binds
+    /// that range to a uniform block binding point, so per-draw data costs a memcpy and one bind rather than a uniform
+    /// upload through the driver. The ring is split into one region per frame in flight, each guarded by a fence.
+    struct UniformRingBuffer
+    {
+        virtual ~UniformRingBuffer() = default;
+
+        /// @brief Start writing into the next frame's region; only blocks if the GPU is still reading it
+        virtual void begin_frame() = 0;
+
+        /// @brief Mark the end of this frame's draws so its region can be reused once the GPU is done with it
+        virtual void end_frame() = 0;
+
+        virtual void push(UniformBlock binding, const void* data, u32 size) = 0;
+
+        template<typename T>
+        void push(UniformBlock binding, const T& block) { push(binding, &block, sizeof(T)); }
+
+        /// @param frame_size Bytes available to push() per frame; each push is padded to the driver's offset alignment
+        static Ref<UniformRingBuffer> create(u32 frame_size);
+    };
+
+    /// @brief C++ mirrors of the shared uniform blocks using std140 layout. Every vec3 is followed by a scalar (or explicit
+    /// padding) to fill its 16-byte slot; the offsets are static_asserted so drifting from the GLSL declaration fails to compile.
+    namespace std140
+    {
+        /// @brief must match MAX_POINT_LIGHTS in res/lights.glsl
+        constexpr u32 MAX_POINT_LIGHTS = 4;
+
+        struct Camera
+        {
+            glm::mat4 projection;
+            glm::mat4 view;
+            glm::vec3 position;
+            float _pad0;
+        };
+
+        static_assert(offsetof(Camera, projection)  == 0);
+        static_assert(offsetof(Camera, view)        == 64);
+        static_assert(offsetof(Camera, position)    == 128);
+        static_assert(sizeof(Camera)                == 144);
+
+        struct Object
+        {
+            glm::mat4 model;
+        };
+
+        static_assert(offsetof(Object, model)   == 0);
+        static_assert(sizeof(Object)            == 64);
+
+        struct DirectionalLight
+        {
+            glm::vec3 direction;
+            float _pad0;
+            glm::vec3 ambient;
+            float _pad1;
+            glm::vec3 diffuse;
+            float _pad2;
+            glm::vec3 specular;
+            float _pad3;
+        };
+
+        static_assert(offsetof(DirectionalLight, direction) == 0);
+        static_assert(offsetof(DirectionalLight, ambient)   == 16);
+        static_assert(offsetof(DirectionalLight, diffuse)   == 32);
+        static_assert(offsetof(DirectionalLight, specular)  == 48);
+        static_assert(sizeof(DirectionalLight)              == 64);
+
+        struct PointLight
+        {
+            glm::vec3 position;
+            float constant;
+            glm::vec3 ambient;
+            float linear;
+            glm::vec3 diffuse;
+            float quadratic;
+            glm::vec3 specular;
+            float _pad0;
+        };
+
+        static_assert(offsetof(PointLight, position)    == 0);
+        static_assert(offsetof(PointLight, constant)    == 12);
+        static_assert(offsetof(PointLight, ambient)     == 16);
+        static_assert(offsetof(PointLight, linear)      == 28);
+        static_assert(offsetof(PointLight, diffuse)     == 32);
+        static_assert(offsetof(PointLight, quadratic)   == 44);
+        static_assert(offsetof(PointLight, specular)    == 48);
+        static_assert(sizeof(PointLight)                == 64);
+
+        struct Spotlight
+        {
+            glm::vec3 position;
+            float cutoff;
+            glm::vec3 direction;
+            float outer_cutoff;
+            glm::vec3 ambient;
+            float constant;
+            glm::vec3 diffuse;
+            float linear;
+            glm::vec3 specular;
+            float quadratic;
+        };
+
+        static_assert(offsetof(Spotlight, position)     == 0);
+        static_assert(offsetof(Spotlight, cutoff)       == 12);
+        static_assert(offsetof(Spotlight, direction)    == 16);
+        static_assert(offsetof(Spotlight, outer_cutoff) == 28);
+        static_assert(offsetof(Spotlight, ambient)      == 32);
+        static_assert(offsetof(Spotlight, constant)     == 44);
+        static_assert(offsetof(Spotlight, diffuse)      == 48);
+        static_assert(offsetof(Spotlight, linear)       == 60);
+        static_assert(offsetof(Spotlight, specular)     == 64);
+        static_assert(offsetof(Spotlight, quadratic)    == 76);
+        static_assert(sizeof(Spotlight)                 == 80);
+
+        struct Lights
+        {
+            DirectionalLight directional;
+            PointLight point_lights[MAX_POINT_LIGHTS];
+            Spotlight spotlight;
+        };
+
+        static_assert(offsetof(Lights, directional)     == 0);
+        static_assert(offsetof(Lights, point_lights)    == 64);
+        static_assert(offsetof(Lights, spotlight)       == 64 + 64 * MAX_POINT_LIGHTS);
+        static_assert(sizeof(Lights)                    == 144 + 64 * MAX_POINT_LIGHTS);
+    } // namespace std140
+
     struct VertexArray
     {
         virtual ~VertexArray() = default;
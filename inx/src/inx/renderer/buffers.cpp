@@ -74,4 +74,18 @@ namespace inx
         auto result = std::make_shared<OpenGLIndexBuffer>(indices, count);
         return result;
     }
+
+    Ref<UniformBuffer> UniformBuffer::create(u32 size, UniformBlock binding)
+    {
+        // NOTE(selina): In the future this will change what it returns based on current rendering API - 16/08
+        auto result = std::make_shared<OpenGLUniformBuffer>(size, (u32)binding);
+        return result;
+    }
+
+    Ref<UniformRingBuffer> UniformRingBuffer::create(u32 frame_size)
+    {
+        // NOTE(selina): In the future this will change what it returns based on current rendering API - 16/08
+        auto result = std::make_shared<OpenGLUniformRingBuffer>(frame_size);
+        return result;
+    }
 } // namespace inx
\ No newline at end of file
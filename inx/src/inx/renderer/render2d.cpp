@@ -1,6 +1,7 @@
 #include "../renderer.h"
 
-#include <array>
+#include <algorithm>
+#include <vector>
 
 #include <glad/glad.h>
 #include <glm/gtc/matrix_transform.hpp>
@@ -16,6 +17,9 @@ namespace inx
         
         glm::vec2 tex_coord;
         float tex_index;
+
+        /// @brief layer of the batch's texture array, or -1 to sample the `tex_index` slot instead
+        float tex_layer;
     };
 
     struct Render2DData
@@ -23,14 +27,25 @@ namespace inx
         static constexpr u32 MAX_QUADS          = 20000;
         static constexpr u32 MAX_VERTICES       = MAX_QUADS * 4;
         static constexpr u32 MAX_INDICES        = MAX_QUADS * 6;
-        static constexpr u32 MAX_TEXTURE_SLOTS  = 32;
+
+        /// @brief most units the quad shader is written for; quad.fs has a SAMPLE case for every one but the last
+        static constexpr u32 MAX_TEXTURE_UNITS  = 32;
+
+        /// @brief 2D slots per batch; every unit the driver offers except the one left for the texture array
+        u32 max_texture_slots = 0;
+
+        /// @brief unit the texture array is bound to, after the 2D slots
+        u32 array_texture_slot = 0;
 
         Ref<VertexArray> quad_vao;
         Ref<VertexBuffer> quad_vbo;
 
-        std::array<u32, MAX_TEXTURE_SLOTS> texture_slots;
+        std::vector<const Texture*> texture_slots;
         u32 texture_slot_index = 1;
 
+        /// @brief one array per batch; layers within it never break the batch
+        const Texture2DArray* texture_array = nullptr;
+
         QuadVertex* vertices = nullptr;
         QuadVertex* vertices_ptr = nullptr;
         
@@ -45,6 +60,11 @@ namespace inx
     {
         if (RENDER_DATA.quad_vao) return;
 
+        // every slot is an active sampler in the quad shader, so the batch can't use more than the driver has units
+        RENDER_DATA.max_texture_slots = std::min(render_api::max_texture_units(), RENDER_DATA.MAX_TEXTURE_UNITS) - 1;
+        RENDER_DATA.array_texture_slot = RENDER_DATA.max_texture_slots;
+        RENDER_DATA.texture_slots.assign(RENDER_DATA.max_texture_slots, nullptr);
+
         RENDER_DATA.quad_vao = VertexArray::create();
 
         RENDER_DATA.quad_vbo = VertexBuffer::create(RENDER_DATA.MAX_VERTICES * sizeof(QuadVertex));
@@ -53,6 +73,7 @@ namespace inx
             { "colour",    BufferElementDataType::Float4 },
             { "tex_coord", BufferElementDataType::Float2 },
             { "tex_index", BufferElementDataType::Float },
+            { "tex_layer", BufferElementDataType::Float },
         });
 
         RENDER_DATA.quad_vao->add_vertex_buffer(RENDER_DATA.quad_vbo);
@@ -81,9 +102,13 @@ namespace inx
         delete[] indices;
 
         TextureSpec spec;
-        manager.load_resource<Texture>("r2d_white", spec);
+        spec.format = ImageFormat::RGBA8;
+        auto& white = manager.get_resource(manager.load_resource<Texture>("r2d_white", spec));
         u32 texture_data = 0xffffffff;
-        manager.get_resource<Texture>("r2d_white").data(&texture_data, sizeof(u32));
+        white.data(&texture_data, sizeof(u32));
+
+        // slot 0 is always white so untextured quads can share batches with textured ones
+        RENDER_DATA.texture_slots[0] = &white;
 
         RENDER_DATA.quad_positions[0] = { -0.5f, -0.5f, 0.0f, 1.0f };
 		RENDER_DATA.quad_positions[1] = {  0.5f, -0.5f, 0.0f, 1.0f };
@@ -96,10 +121,27 @@ namespace inx
         delete[] RENDER_DATA.vertices;
     }
 
+    u32 render2d::texture_slot_count()
+    {
+        return RENDER_DATA.max_texture_slots;
+    }
+
+    u32 render2d::array_texture_unit()
+    {
+        return RENDER_DATA.array_texture_slot;
+    }
+
+    void render2d::register_warm_up(const Shader& shader)
+    {
+        render_api::register_warm_up(shader, RENDER_DATA.quad_vao);
+    }
+
     void render2d::begin_batch()
     {
         RENDER_DATA.index_count = 0;
         RENDER_DATA.vertices_ptr = RENDER_DATA.vertices;
+        RENDER_DATA.texture_slot_index = 1;
+        RENDER_DATA.texture_array = nullptr;
     }
 
     void render2d::end_batch()
@@ -110,34 +152,99 @@ namespace inx
 
     void render2d::flush()
     {
+        for (u32 i = 0; i < RENDER_DATA.texture_slot_index; i++)
+            RENDER_DATA.texture_slots[i]->bind(GL_TEXTURE0 + i);
+
+        if (RENDER_DATA.texture_array)
+            RENDER_DATA.texture_array->bind(GL_TEXTURE0 + RENDER_DATA.array_texture_slot);
+
         RENDER_DATA.quad_vao->bind();
         glDrawElements(GL_TRIANGLES, RENDER_DATA.index_count, GL_UNSIGNED_INT, nullptr);
     }
 
-    void render2d::draw_quad(const glm::vec3& position, const glm::vec2& size, const glm::vec4& colour)
+    static void _push_quad(const glm::vec3& position, const glm::vec2& size, const glm::vec4& colour, const glm::vec2 tex_coords[4], float texture_index, float texture_layer = -1.f)
     {
         glm::mat4 transform = glm::translate(glm::mat4(1.f), position) * glm::scale(glm::mat4(1.f), { size.x, size.y, 1.f });
 
-        if (RENDER_DATA.index_count >= RENDER_DATA.MAX_INDICES)
-        {
-            render2d::end_batch();
-            render2d::flush();
-            render2d::begin_batch();
-        }
-
         constexpr size_t quad_count = 4;
-        constexpr float texture_index = 0.0f;
-        constexpr glm::vec2 textureCoords[] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
-
         for (size_t i = 0; i < quad_count; i++)
         {
             RENDER_DATA.vertices_ptr->position = transform * RENDER_DATA.quad_positions[i];
             RENDER_DATA.vertices_ptr->colour = colour;
-            RENDER_DATA.vertices_ptr->tex_coord = textureCoords[i];
+            RENDER_DATA.vertices_ptr->tex_coord = tex_coords[i];
             RENDER_DATA.vertices_ptr->tex_index = texture_index; 
+            RENDER_DATA.vertices_ptr->tex_layer = texture_layer;
             RENDER_DATA.vertices_ptr++;
         }
 
         RENDER_DATA.index_count += 6;
     }
+
+    static void _next_batch()
+    {
+        render2d::end_batch();
+        render2d::flush();
+        render2d::begin_batch();
+    }
+
+    void render2d::draw_quad(const glm::vec3& position, const glm::vec2& size, const glm::vec4& colour)
+    {
+        if (RENDER_DATA.index_count >= RENDER_DATA.MAX_INDICES)
+            _next_batch();
+
+        constexpr float texture_index = 0.0f;
+        constexpr glm::vec2 textureCoords[] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+
+        _push_quad(position, size, colour, textureCoords, texture_index);
+    }
+
+    void render2d::draw_quad(const glm::vec3& position, const glm::vec2& size, const AtlasRegion& region, const glm::vec4& tint)
+    {
+        if (RENDER_DATA.index_count >= RENDER_DATA.MAX_INDICES)
+            _next_batch();
+
+        // find the page's slot, claiming a new one if it isn't bound in this batch yet
+        u32 slot = 0;
+        for (u32 i = 1; i < RENDER_DATA.texture_slot_index; i++)
+        {
+            if (RENDER_DATA.texture_slots[i] == region.texture)
+            {
+                slot = i;
+                break;
+            }
+        }
+
+        if (slot == 0)
+        {
+            if (RENDER_DATA.texture_slot_index >= RENDER_DATA.max_texture_slots)
+                _next_batch();
+
+            slot = RENDER_DATA.texture_slot_index++;
+            RENDER_DATA.texture_slots[slot] = region.texture;
+        }
+
+        const glm::vec2 tex_coords[] = {
+            { region.uv_min.x, region.uv_min.y },
+            { region.uv_max.x, region.uv_min.y },
+            { region.uv_max.x, region.uv_max.y },
+            { region.uv_min.x, region.uv_max.y },
+        };
+
+        _push_quad(position, size, tint, tex_coords, (float)slot);
+    }
+
+    void render2d::draw_quad(const glm::vec3& position, const glm::vec2& size, const ArrayLayer& layer, const glm::vec4& tint)
+    {
+        if (RENDER_DATA.index_count >= RENDER_DATA.MAX_INDICES)
+            _next_batch();
+
+        if (RENDER_DATA.texture_array && RENDER_DATA.texture_array != layer.texture)
+            _next_batch();
+
+        RENDER_DATA.texture_array = layer.texture;
+
+        constexpr glm::vec2 textureCoords[] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+
+        _push_quad(position, size, tint, textureCoords, 0.f, (float)layer.layer);
+    }
 } // namespace inx
\ No newline at end of file
@@ -6,6 +6,8 @@
 struct APIData
 {
     inx::Ref<inx::RenderAPI> api;
+
+    std::vector<inx::WarmUpEntry> warm_up_entries;
 };
 
 static APIData API_DATA;
@@ -32,4 +34,37 @@ namespace inx
     {
         API_DATA.api->clear();
     }
+
+    void render_api::blend(BlendMode mode)
+    {
+        API_DATA.api->blend(mode);
+    }
+
+    u32 render_api::max_texture_units()
+    {
+        return API_DATA.api->max_texture_units();
+    }
+
+    void render_api::register_warm_up(const Shader& shader, const Ref<VertexArray>& vertex_array, BlendMode blend, const Texture* texture)
+    {
+        API_DATA.warm_up_entries.push_back({ &shader, vertex_array, blend, texture });
+    }
+
+    void render_api::warm_up()
+    {
+        API_DATA.api->warm_up(API_DATA.warm_up_entries);
+
+        // the combinations only need warming once; don't keep the resources alive for it
+        API_DATA.warm_up_entries.clear();
+    }
+
+    bool render_api::start_upload_thread(SDL_Window* window)
+    {
+        return API_DATA.api->start_upload_thread(window);
+    }
+
+    void render_api::stop_upload_thread()
+    {
+        API_DATA.api->stop_upload_thread();
+    }
 } // namespace inx
\ No newline at end of file
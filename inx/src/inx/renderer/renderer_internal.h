@@ -5,6 +5,14 @@
 
 namespace inx
 {
+    struct WarmUpEntry
+    {
+        const Shader* shader;
+        Ref<VertexArray> vertex_array;
+        BlendMode blend;
+        const Texture* texture;
+    };
+
     struct RenderAPI
     {
         virtual ~RenderAPI() = default;
@@ -13,6 +21,15 @@ namespace inx
         virtual void viewport(i32 width, i32 height) const = 0;
         virtual void clear_colour(const glm::vec3&  colour) const = 0;
         virtual void clear() const = 0;
+
+        virtual void blend(BlendMode mode) const = 0;
+
+        virtual u32 max_texture_units() const = 0;
+
+        virtual void warm_up(const std::vector<WarmUpEntry>& entries) const = 0;
+
+        virtual bool start_upload_thread(SDL_Window* window) const = 0;
+        virtual void stop_upload_thread() const = 0;
     };
 } // namespace inx
 
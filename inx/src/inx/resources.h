@@ -1,11 +1,18 @@
 #ifndef __INX_RESOURCES_H__
 #define __INX_RESOURCES_H__
 
+#include <atomic>
 #include <concepts>
+#include <exception>
 #include <filesystem>
+#include <functional>
+#include <map>
+#include <optional>
 #include <string>
-#include <typeindex>
-#include <unordered_map>
+#include <string_view>
+#include <typeinfo>
+#include <utility>
+#include <vector>
 #include <iostream>
 
 #include <glm/glm.hpp>
@@ -14,67 +21,440 @@
 
 namespace inx
 {
+    struct ResourceManager;
+
     template<typename T, typename... Args>
     concept is_loadable = requires(Args... args) 
     {  
         { T::load(args...) } -> std::same_as<Scope<T>>;
     };
 
+    /// @brief Types loaded in two steps: prepare() does the file I/O and decoding on a worker thread and must not touch
+    /// the GL context; finalise() turns its result into the resource on the render thread.
+    template<typename T, typename... Args>
+    concept is_async_loadable = requires(ResourceManager& manager, Args... args)
+    {
+        { T::finalise(manager, T::prepare(args...)) } -> std::same_as<Scope<T>>;
+    };
+
     struct Resource
     {
     public:
         virtual ~Resource() = default;
     };
 
+    /// @brief Name of a resource, hashed with 64-bit FNV-1a. Built from a string literal (or the "name"_rid literal) the
+    /// hash is computed at compile time, so looking a resource up by name neither allocates nor hashes at runtime.
+    struct ResourceId
+    {
+    public:
+        u64 hash = 0;
+
+        constexpr ResourceId() = default;
+        constexpr ResourceId(std::string_view name) : hash(hash_fnv1a64(name)) {}
+        constexpr ResourceId(const char* name) : ResourceId(std::string_view(name)) {}
+        ResourceId(const std::string& name) : ResourceId(std::string_view(name)) {}
+
+        bool operator==(const ResourceId&) const = default;
+    };
+
+    inline namespace literals
+    {
+        consteval ResourceId operator""_rid(const char* name, size_t length)
+        {
+            return ResourceId(std::string_view(name, length));
+        }
+    } // namespace literals
+
+    /// @brief Typed reference to a resource held by a ResourceManager. Resolving one is an array index, so keep the
+    /// handle load_resource() returns rather than looking the resource up by name every frame. Unloading or
+    /// replacing the resource bumps its slot's generation, which debug builds use to catch handles to the old one.
+    template<typename T>
+    struct Handle
+    {
+    public:
+        constexpr static const u32 INVALID = 0xffffffff;
+
+        u32 index = INVALID;
+        u32 generation = 0;
+
+        bool valid() const { return index != INVALID; }
+        bool operator==(const Handle&) const = default;
+    };
+
+    /// @brief Dense index per resource type, shared by every manager, so a type's pool is found without hashing
+    u32 next_resource_type();
+
+    template<typename T>
+    u32 resource_type()
+    {
+        static const u32 type = next_resource_type();
+        return type;
+    }
+
+    /// @brief A resource that an asynchronous load has to wait for: it is only finalised once every one of its
+    /// dependencies has been
+    struct ResourceDependency
+    {
+    public:
+        template<typename T>
+        ResourceDependency(Handle<T> handle)
+            : type(resource_type<T>()), index(handle.index), generation(handle.generation) {}
+
+        u32 type;
+        u32 index;
+        u32 generation;
+    };
+
     struct ResourceManager
     {
     public:
+        /// @brief Load a resource with T::load and name it `resource_id`. Loading over an existing name replaces
+        /// that resource and invalidates handles to it.
         template<typename T, typename... Args>
         requires std::is_base_of_v<Resource, T> && is_loadable<T, Args...>
-        void load_resource(const std::string& resource_id, Args... args)
+        Handle<T> load_resource(std::string_view resource_id, Args... args)
+        {
+            return add_resource<T>(resource_id, T::load(args...));
+        }
+
+        /// @brief Start loading a resource in the background and return its handle straight away. T::prepare runs on
+        /// a worker; T::finalise runs in a later process_loads() once every resource T::dependencies (if T declares
+        /// it) names has been finalised. Until then is_loaded() is false for the handle and it must not be resolved.
+        template<typename T, typename... Args>
+        requires std::is_base_of_v<Resource, T> && is_async_loadable<T, Args...>
+        Handle<T> load_resource_async(std::string_view resource_id, Args... args)
         {
-            const auto type_index = std::type_index(typeid(T));
-            _resources[type_index][resource_id] = T::load(args...);
+            const u32 index = _reserve<T>(resource_id);
+            const Handle<T> handle = { index, _pools[resource_type<T>()].slots[index].generation };
+
+            // the worker's result; only read by finalise once `prepared` is set
+            auto prepared = create_ref<std::optional<decltype(T::prepare(args...))>>();
+
+            auto load = create_ref<PendingLoad>(handle);
+            load->name = resource_id;
+            if constexpr (requires { T::dependencies(args...); })
+                load->dependencies = T::dependencies(args...);
+
+            load->finalise = [handle, prepared](ResourceManager& manager)
+            {
+                manager._finish(handle, T::finalise(manager, std::move(**prepared)));
+            };
+            _pending.push_back(load);
+
+            _submit([load, prepared, args...]()
+            {
+                try
+                {
+                    prepared->emplace(T::prepare(args...));
+                }
+                catch (...)
+                { // rethrown on the render thread by process_loads()
+                    load->error = std::current_exception();
+                }
+
+                load->prepared.store(true, std::memory_order_release);
+            });
+
+            return handle;
+        }
+
+        /// @brief Finalise every asynchronous load that is ready, in dependency order. Call once per frame from the
+        /// render thread; rethrows anything a prepare() threw.
+        void process_loads();
+
+        /// @brief Block until every asynchronous load so far has been finalised, e.g. at the end of a level load
+        void finish_loads();
+
+        /// @brief number of asynchronous loads not finalised yet
+        size_t pending_loads() const { return _pending.size(); }
+
+        /// @brief Store a resource that was created by something other than T::load, e.g. regions generated by an atlas
+        template<typename T>
+        requires std::is_base_of_v<Resource, T>
+        Handle<T> add_resource(std::string_view resource_id, Scope<T> resource)
+        {
+            const u32 index = _reserve<T>(resource_id);
+
+            auto& slot = _pools[resource_type<T>()].slots[index];
+            slot.resource = std::move(resource);
+
+            return { index, slot.generation };
         }
 
+        /// @brief Destroy a resource, or abandon its asynchronous load; its slot is reused by a later load and any
+        /// remaining handles to it go stale
         template<typename T>
         requires std::is_base_of_v<Resource, T>
-        [[nodiscard]] T& get_resource(const std::string& resource_id)
+        void unload_resource(Handle<T> handle)
         {
-            if (!is_loaded<T>(resource_id))
-            { // check if resource exists; throw error if not found
-                std::cerr << "Resource [" << resource_id << "] not found.\n";
-                throw std::runtime_error(std::string("Could not find resource: ") + resource_id);
+            auto& pool = _pool<T>();
+            if (!handle.valid() || handle.index >= pool.slots.size() || pool.slots[handle.index].generation != handle.generation)
+            {
+                std::cerr << "Stale resource handle [" << handle.index << ", generation " << handle.generation << "] unloaded\n";
+                throw std::runtime_error("Stale resource handle");
             }
 
-            // because we check std::is_base_of<T, V>, we know this is a valid conversion
-            Resource* resource_ptr = _resources[std::type_index(typeid(T))][resource_id].get();
-            T* resource = dynamic_cast<T*>(resource_ptr);
+            _release(resource_type<T>(), handle.index);
+        }
 
-            return *resource;
+        template<typename T>
+        requires std::is_base_of_v<Resource, T>
+        [[nodiscard]] T& get_resource(Handle<T> handle)
+        {
+            _check<T>(handle);
+
+            // add_resource only ever stores a T in a T's pool
+            return static_cast<T&>(*_pools[resource_type<T>()].slots[handle.index].resource);
         }
 
+        /// @brief Look a resource up by name; an invalid handle if there is none. Takes "name"_rid, a string literal
+        /// or a string_view. Meant for tools and setup code, hold on to the handle rather than calling this per frame.
         template<typename T>
         requires std::is_base_of_v<Resource, T>
-        [[nodiscard]] bool is_loaded(const std::string& resource_id) const noexcept
+        [[nodiscard]] Handle<T> find_resource(ResourceId resource_id) const noexcept
         {
-            bool found = false;
-            
-            if (const auto& outer_it = _resources.find(std::type_index(typeid(T))); outer_it != _resources.end()) 
-            { // search outer map to see if we store this resource type
-                const auto& resource_map = outer_it->second;
+            const u32 type = resource_type<T>();
+            if (type >= _pools.size()) return {};
 
-                if (const auto& inner_it = resource_map.find(resource_id); inner_it != resource_map.end()) 
-                { // search inner map to see if we have this specific resource loaded
-                    found = true;
-                }
+            const auto& pool = _pools[type];
+            if (u32 index = pool.ids.find(resource_id.hash); index != IdTable::NONE)
+                return { index, pool.slots[index].generation };
+
+            return {};
+        }
+
+        /// @brief Name based get_resource, for tools; throws if there is no such resource
+        template<typename T>
+        requires std::is_base_of_v<Resource, T>
+        [[nodiscard]] T& get_resource(ResourceId resource_id)
+        {
+            auto handle = find_resource<T>(resource_id);
+            if (!handle.valid())
+            { // check if resource exists; throw error if not found. Only the hash is known here
+                std::cerr << "Resource [" << std::hex << resource_id.hash << std::dec << "] not found.\n";
+                throw std::runtime_error("Could not find resource");
             }
 
-            return found;
+            return get_resource(handle);
+        }
+
+        template<typename T>
+        requires std::is_base_of_v<Resource, T>
+        [[nodiscard]] bool is_loaded(Handle<T> handle) const noexcept
+        {
+            const u32 type = resource_type<T>();
+            if (!handle.valid() || type >= _pools.size()) return false;
+
+            const auto& slots = _pools[type].slots;
+            return handle.index < slots.size() && slots[handle.index].generation == handle.generation && slots[handle.index].resource;
+        }
+
+        template<typename T>
+        requires std::is_base_of_v<Resource, T>
+        [[nodiscard]] bool is_loaded(ResourceId resource_id) const noexcept
+        {
+            return is_loaded(find_resource<T>(resource_id));
         }
 
     private:
-        std::unordered_map<std::type_index, std::unordered_map<std::string, Scope<Resource>>> _resources;
+        struct Slot
+        {
+            Scope<Resource> resource;
+            std::string name;
+            ResourceId id;
+            u32 generation = 0;
+        };
+
+        /// @brief Open addressing (linear probing) map from a ResourceId hash to a slot index. Entries sit in one
+        /// flat array, so a lookup is a few compares in adjacent memory.
+        struct IdTable
+        {
+        public:
+            constexpr static const u32 NONE = 0xffffffff;
+
+            /// @brief the slot index stored for `hash`, or NONE
+            u32 find(u64 hash) const;
+            void insert(u64 hash, u32 index);
+            void erase(u64 hash);
+
+        private:
+            struct Entry
+            {
+                u64 hash = 0;
+                u32 index = NONE;
+            };
+
+            void _grow();
+
+            std::vector<Entry> _entries;
+            u32 _count = 0;
+        };
+
+        /// @brief Every resource of one type; slots are never removed, only emptied and reused
+        struct Pool
+        {
+            std::vector<Slot> slots;
+            std::vector<u32> free;
+            IdTable ids;
+        };
+
+        /// @brief an asynchronous load between load_resource_async() and its finalise
+        struct PendingLoad
+        {
+            template<typename T>
+            PendingLoad(Handle<T> handle) : slot(handle) {}
+
+            /// @brief the slot the result goes in; a failed load frees it, so loads depending on it fail too
+            ResourceDependency slot;
+
+            std::string name;
+            std::vector<ResourceDependency> dependencies;
+
+            /// @brief set by the worker once prepare() has returned or thrown
+            std::atomic<bool> prepared = false;
+            std::exception_ptr error;
+
+            std::function<void(ResourceManager&)> finalise;
+        };
+
+        template<typename T>
+        Pool& _pool()
+        {
+            const u32 type = resource_type<T>();
+            if (type >= _pools.size()) _pools.resize(type + 1);
+            return _pools[type];
+        }
+
+        /// @brief Find or allocate the slot named `resource_id`, emptying it and bumping its generation if it was in
+        /// use, so a new resource can go in
+        template<typename T>
+        u32 _reserve(std::string_view resource_id)
+        {
+            auto& pool = _pool<T>();
+            const ResourceId id(resource_id);
+
+            u32 index = pool.ids.find(id.hash);
+            if (index != IdTable::NONE)
+            {
+#ifndef NDEBUG
+                if (pool.slots[index].name != resource_id)
+                { // the two names would silently share one resource
+                    std::cerr << "Resource id collision: " << resource_id << " and " << pool.slots[index].name << "\n";
+                    throw std::runtime_error(std::string("Resource id collision: ") + std::string(resource_id));
+                }
+#endif
+                pool.slots[index].generation++;
+            }
+            else
+            {
+                if (!pool.free.empty())
+                {
+                    index = pool.free.back();
+                    pool.free.pop_back();
+                }
+                else
+                {
+                    index = (u32)pool.slots.size();
+                    pool.slots.emplace_back();
+                }
+
+                pool.ids.insert(id.hash, index);
+            }
+
+            auto& slot = pool.slots[index];
+            slot.resource.reset();
+            slot.name = resource_id;
+            slot.id = id;
+
+            return index;
+        }
+
+        /// @brief Empty a slot and free it for reuse; handles to it go stale
+        void _release(u32 type, u32 index);
+
+        /// @brief free the slot of a load that failed, or whose dependencies did
+        void _release_failed(const PendingLoad& load);
+
+        /// @brief Store the result of an asynchronous load, unless its slot was unloaded or reused in the meantime
+        template<typename T>
+        void _finish(Handle<T> handle, Scope<T> resource)
+        {
+            auto& slot = _pools[resource_type<T>()].slots[handle.index];
+            if (slot.generation == handle.generation) slot.resource = std::move(resource);
+        }
+
+        /// @brief Jobs::submit, kept out of this header
+        static void _submit(std::function<void()> job);
+
+
+        template<typename T>
+        void _check([[maybe_unused]] Handle<T> handle) const
+        {
+#ifndef NDEBUG
+            if (!is_loaded(handle))
+            { // the handle is invalid, its resource is still loading, or was unloaded or replaced since
+                std::cerr << "Stale resource handle [" << handle.index << ", generation " << handle.generation << "] for " << typeid(T).name() << "\n";
+                throw std::runtime_error("Stale resource handle");
+            }
+#endif
+        }
+
+        std::vector<Pool> _pools;
+
+        /// @brief in the order they were started, which process_loads() keeps among loads that are ready together
+        std::vector<Ref<PendingLoad>> _pending;
+    };
+
+    /// @brief Pre-resolved handle to a shader uniform. Resolve once with Shader::uniform() and reuse it every frame;
+    /// setting a uniform through a handle does no name lookup or allocation.
+    struct UniformId
+    {
+        /// @brief location of the uniform in the program; -1 if the uniform does not exist or was optimised out
+        i32 location = -1;
+
+        /// @brief index into the owning shader's reflection table
+        u32 index = 0;
+
+        /// @brief API specific type of the uniform; used for type checking in debug builds
+        u32 type = 0;
+
+        /// @brief for shaders made of several programs, the index of the program the uniform was resolved in
+        u32 stage = 0;
+
+        bool valid() const { return location >= 0; }
+    };
+
+    /// @brief Counts of uniform sets since the last reset, split by whether they reached the driver
+    struct UniformStats
+    {
+        u32 uploads = 0;
+
+        /// @brief sets skipped because the value matched what the program already held
+        u32 elided = 0;
+    };
+
+    /// @brief Feature defines injected into a shader's sources, e.g. { "NR_POINT_LIGHTS", "2" }. Ordered so that equal
+    /// sets always produce identical sources and therefore share a compiled variant.
+    using ShaderDefines = std::map<std::string, std::string>;
+
+    enum class ShaderLinkage
+    {
+        /// @brief every stage is linked into one program
+        Monolithic,
+
+        /// @brief each stage is its own separable program, combined with the others in a pipeline at bind time. Stages
+        /// are shared between every shader that uses the same file with the same defines, so new combinations never
+        /// need a relink.
+        Separable,
+    };
+
+    /// @brief A shader's stages read and preprocessed, ready to compile
+    struct ShaderSources
+    {
+        std::string vertex;
+        std::string fragment;
+        ShaderLinkage linkage = ShaderLinkage::Monolithic;
     };
 
     struct Shader : public Resource
@@ -84,18 +464,89 @@ namespace inx
 
         virtual void bind() const = 0;
 
-        virtual void set_int(const std::string& name, int i) const = 0;
-        virtual void set_ints(const std::string& name, int* ints, u32 count) const = 0;
-        virtual void set_float(const std::string& name, float f) const = 0;
-        virtual void set_vec3(const std::string& name, const glm::vec3& vec) const = 0;
-        virtual void set_mat4(const std::string& name, const glm::mat4& mat) const = 0;
+        /// @brief Poll whether the program has finished compiling and linking. Never blocks when the driver supports
+        /// parallel compilation; otherwise it finishes the link on the spot. Binding or resolving a uniform on a shader
+        /// that isn't ready blocks until it is.
+        virtual bool is_ready() const = 0;
+
+        /// @brief Resolve a uniform name into a handle using the table reflected from the program after linking
+        /// @param name Name of the uniform as it appears in GLSL, e.g. "u_point_lights[0].position"
+        /// @return Handle to the uniform; invalid (but safe to set) if the program has no such uniform
+        virtual UniformId uniform(std::string_view name) const = 0;
+
+        virtual void set_int(UniformId id, int i) const = 0;
+        virtual void set_ints(UniformId id, int* ints, u32 count) const = 0;
+        virtual void set_float(UniformId id, float f) const = 0;
+        virtual void set_vec3(UniformId id, const glm::vec3& vec) const = 0;
+        virtual void set_mat4(UniformId id, const glm::mat4& mat) const = 0;
+
+        virtual void set_int(std::string_view name, int i) const = 0;
+        virtual void set_ints(std::string_view name, int* ints, u32 count) const = 0;
+        virtual void set_float(std::string_view name, float f) const = 0;
+        virtual void set_vec3(std::string_view name, const glm::vec3& vec) const = 0;
+        virtual void set_mat4(std::string_view name, const glm::mat4& mat) const = 0;
 
-        static Scope<Shader> load(const std::filesystem::path& vertex_filepath, const std::filesystem::path& fragment_filepath);
+        /// @brief Start compiling a shader program. Returns as soon as the compile has been issued so that loading
+        /// several shaders back to back lets the driver overlap their compiles; errors surface on first use.
+        /// @param defines Feature defines for this variant. Loading the same files with the same defines again reuses
+        /// the already compiled program (or stages, for separable shaders).
+        static Scope<Shader> load(const std::filesystem::path& vertex_filepath, const std::filesystem::path& fragment_filepath, const ShaderDefines& defines = {}, ShaderLinkage linkage = ShaderLinkage::Monolithic);
+
+        /// @brief The two halves of load() for ResourceManager::load_resource_async: prepare() reads and preprocesses
+        /// the files on a worker, finalise() issues the compile
+        static ShaderSources prepare(const std::filesystem::path& vertex_filepath, const std::filesystem::path& fragment_filepath, const ShaderDefines& defines = {}, ShaderLinkage linkage = ShaderLinkage::Monolithic);
+        static Scope<Shader> finalise(ResourceManager& manager, ShaderSources&& sources);
+
+        /// @brief Uniform upload counters across every shader; reset once per frame with reset_uniform_stats()
+        static UniformStats uniform_stats();
+        static void reset_uniform_stats();
     };
 
     enum class ImageFormat
     {
         None = 0, R8, RGB8, RGBA8,
+
+        // block compressed; only loadable from KTX2 files. BC1_RGB blocks decode their fourth colour as opaque black,
+        // BC1 ones as transparent black.
+        BC1_RGB, BC1, BC3, BC7, ETC2_RGB8, ETC2_RGBA8,
+    };
+
+    constexpr bool is_compressed(ImageFormat format)
+    {
+        return format >= ImageFormat::BC1_RGB;
+    }
+
+    enum class TextureFilter
+    {
+        Nearest, Linear,
+    };
+
+    enum class MipFilter
+    {
+        /// @brief only ever sample level 0
+        None, Nearest, Linear,
+    };
+
+    enum class TextureWrap
+    {
+        Repeat, MirroredRepeat, ClampToEdge,
+    };
+
+    /// @brief How a texture is sampled. Kept apart from the texture itself, so the same texture can be sampled
+    /// different ways; every distinct Sampler maps to one shared sampler object.
+    struct Sampler
+    {
+        TextureFilter min_filter = TextureFilter::Linear;
+        TextureFilter mag_filter = TextureFilter::Linear;
+        MipFilter mip_filter = MipFilter::Linear;
+
+        TextureWrap wrap_u = TextureWrap::Repeat;
+        TextureWrap wrap_v = TextureWrap::Repeat;
+
+        /// @brief max anisotropic samples, clamped to what the driver supports; 1 turns it off
+        u32 anisotropy = 1;
+
+        bool operator==(const Sampler& other) const = default;
     };
 
     struct TextureSpec
@@ -104,21 +555,302 @@ namespace inx
         u32 height = 1;
         ImageFormat format = ImageFormat::RGB8;
         bool generate_mipmaps = true;
+
+        /// @brief used by bind(slot); bind(slot, sampler) overrides it for one bind
+        Sampler sampler;
+    };
+
+    struct TextureStreamingStats
+    {
+        /// @brief every texture's estimated VRAM use, streamed or not
+        size_t texture_bytes = 0;
+        size_t budget = 0;
+
+        u32 streamed_textures = 0;
+        /// @brief streamed textures that aren't at the detail they were asked for because of the budget
+        u32 constrained_textures = 0;
     };
     
+    struct Image;
+
+    /// @brief A texture file decoded on a worker by Texture::prepare
+    struct TextureSource
+    {
+        std::filesystem::path filepath;
+        Ref<Image> image;
+    };
+
     struct Texture : public Resource
     {
     public:
         virtual ~Texture() = default;
+
+        /// @brief Start loading a texture from disk. The file is decoded on a worker thread; until it has been
+        /// uploaded by process_uploads() the texture is a 1x1 grey placeholder. `.ktx2` files are uploaded as stored,
+        /// compressed formats and mip chain included. Uncompressed ones are flipped per their KTXorientation like any
+        /// other image; compressed ones can't be, so they must be authored bottom-up (KTXorientation "ru").
         static Scope<Texture> load(const std::filesystem::path& texture_filepath);
         static Scope<Texture> load(const TextureSpec& spec);
 
+        /// @brief The two halves of load(path) for ResourceManager::load_resource_async: prepare() decodes the file on
+        /// a worker, finalise() creates the texture with its image already queued for upload
+        static TextureSource prepare(const std::filesystem::path& texture_filepath);
+        static Scope<Texture> finalise(ResourceManager& manager, TextureSource&& source);
+
+        /// @brief Upload textures whose decode has finished, up to roughly `byte_budget` bytes (always at least one
+        /// texture). Call once per frame from the render thread.
+        static void process_uploads(size_t byte_budget = 8 * 1024 * 1024);
+
+        /// @brief Turn on mip streaming for textures loaded from disk from now on, keeping all texture memory under
+        /// `bytes` (0 turns it off). Streamed textures arrive with only their small mips; process_uploads() then
+        /// raises or lowers each one's resident detail based on requested size and how recently it was bound.
+        static void streaming_budget(size_t bytes);
+        static TextureStreamingStats streaming_stats();
+
         virtual void bind(unsigned int slot = 0) const = 0;
+        virtual void bind(unsigned int slot, const Sampler& sampler) const = 0;
+
+        /// @brief Change how bind(slot) samples the texture. Only swaps the sampler object bound alongside it; the
+        /// texture itself is untouched.
+        virtual void sampler(const Sampler& sampler) = 0;
+
+        /// @brief Hint the largest size in pixels the texture covers on screen this frame; without a hint, a
+        /// texture bound this frame wants full detail. Only affects streamed textures.
+        virtual void request_size(u32 pixels) const = 0;
+
+        /// @brief false while the real image is still being loaded and the placeholder is bound instead
+        virtual bool is_ready() const = 0;
 
         virtual const TextureSpec& spec() const = 0;
 
         virtual void data(const void* data, u32 size) = 0; 
     };
+
+    /// @brief What a material is made of. Texture i is bound to unit GL_TEXTURE0 + i and its sampler uniform (the
+    /// name it's paired with) set to that unit.
+    struct MaterialSpec
+    {
+        Handle<Shader> shader;
+        std::vector<std::pair<std::string, Handle<Texture>>> textures;
+    };
+
+    /// @brief A shader and the textures it samples, bound together. Load it with load_resource_async alongside its
+    /// shader and textures and it's finalised once they all have been. It keeps pointers to them, so replacing or
+    /// unloading one means loading the material again.
+    struct Material : public Resource
+    {
+    public:
+        /// @brief For a shader and textures that are already loaded; store the result with add_resource
+        static Scope<Material> create(ResourceManager& manager, const MaterialSpec& spec);
+
+        /// @brief Nothing to read from disk; the spec's handles are what the load waits on
+        static MaterialSpec prepare(const MaterialSpec& spec) { return spec; }
+        static Scope<Material> finalise(ResourceManager& manager, MaterialSpec&& spec);
+        static std::vector<ResourceDependency> dependencies(const MaterialSpec& spec);
+
+        /// @brief Bind the shader and every texture, and point the sampler uniforms at their units. Materials can share
+        /// a shader with their textures in any order, so that's done on every bind; unchanged values are elided by the
+        /// shader. The first bind resolves the uniforms, which waits for the shader to link.
+        void bind() const;
+
+        Shader& shader() const { return *_shader; }
+
+    private:
+        Shader* _shader = nullptr;
+        std::vector<std::pair<std::string, Texture*>> _textures;
+
+        /// @brief one per texture, resolved on first bind
+        mutable std::vector<UniformId> _samplers;
+    };
+
+    struct TextureArraySpec
+    {
+        u32 width = 1;
+        u32 height = 1;
+        u32 layers = 1;
+        ImageFormat format = ImageFormat::RGBA8;
+
+        /// @brief mip levels to allocate; 0 allocates the full chain
+        u32 levels = 1;
+
+        /// @brief clamped by default so layers don't bleed at their edges
+        Sampler sampler = { .wrap_u = TextureWrap::ClampToEdge, .wrap_v = TextureWrap::ClampToEdge };
+    };
+
+    /// @brief Stack of same-sized, same-format images sampled as one texture, so sprites are addressed by layer
+    /// rather than by texture slot
+    struct Texture2DArray : public Resource
+    {
+    public:
+        virtual ~Texture2DArray() = default;
+        static Scope<Texture2DArray> load(const TextureArraySpec& spec);
+
+        virtual void bind(unsigned int slot = 0) const = 0;
+        virtual void bind(unsigned int slot, const Sampler& sampler) const = 0;
+
+        virtual void sampler(const Sampler& sampler) = 0;
+
+        virtual const TextureArraySpec& spec() const = 0;
+
+        /// @brief Fill one mip level of one layer. `size` is only needed (and checked) for compressed formats.
+        virtual void data(u32 layer, const void* data, u32 size, u32 level = 0) = 0;
+
+        /// @brief Rebuild every level below 0 from level 0 for all layers; call once after filling them
+        virtual void generate_mipmaps() = 0;
+    };
+
+    /// @brief An image stored as one layer of a Texture2DArray
+    struct ArrayLayer : public Resource
+    {
+    public:
+        /// @brief owned by the TextureArraySet, which must outlive the layer
+        const Texture2DArray* texture = nullptr;
+        u32 layer = 0;
+
+        u32 width = 0;
+        u32 height = 0;
+    };
+
+    /// @brief Groups images by size and format into texture arrays. Add every image, then build() once.
+    struct TextureArraySet : public Resource
+    {
+    public:
+        /// @brief the most layers GL 4.1 guarantees in one array; larger groups are split
+        constexpr static const u32 MAX_LAYERS = 2048;
+
+        static Scope<TextureArraySet> load();
+
+        /// @brief Queue an image for the next build(); it becomes the ArrayLayer `resource_id`
+        void add(const std::string& resource_id, const std::filesystem::path& image_filepath);
+
+        /// @brief Decode every queued image, create one array per size/format/mip count group and upload the layers.
+        /// An ArrayLayer is added to `manager` for every image.
+        void build(ResourceManager& manager);
+
+        const std::vector<Scope<Texture2DArray>>& arrays() const { return _arrays; }
+
+    private:
+        std::vector<std::pair<std::string, std::filesystem::path>> _queued;
+        std::vector<Scope<Texture2DArray>> _arrays;
+    };
+
+    /// @brief A packed image inside one page of a TextureAtlas
+    struct AtlasRegion : public Resource
+    {
+    public:
+        /// @brief the atlas page; owned by the atlas, which must outlive the region
+        const Texture* texture = nullptr;
+
+        /// @brief texture coordinates of the image's corners within the page (bottom left, top right)
+        glm::vec2 uv_min{ 0.f };
+        glm::vec2 uv_max{ 1.f };
+
+        /// @brief size of the original image in pixels
+        u32 width = 0;
+        u32 height = 0;
+    };
+
+    struct TextureAtlasSpec
+    {
+        u32 page_size = 2048;
+
+        /// @brief pixels of each image's edge repeated around it, so filtering and lower mips don't pull in neighbours
+        u32 padding = 2;
+
+        bool generate_mipmaps = true;
+    };
+
+    /// @brief Packs many small images into a few large texture pages so whole sprite sets draw without switching
+    /// textures. Add every image, then build() once.
+    struct TextureAtlas : public Resource
+    {
+    public:
+        TextureAtlas(const TextureAtlasSpec& spec);
+
+        static Scope<TextureAtlas> load(const TextureAtlasSpec& spec);
+
+        /// @brief Queue an image for the next build(); it becomes the AtlasRegion `resource_id`
+        void add(const std::string& resource_id, const std::filesystem::path& image_filepath);
+
+        /// @brief Decode every queued image, pack them into pages and upload the pages. An AtlasRegion is added to
+        /// `manager` for every image. Images can't be added to a page once it has been built.
+        void build(ResourceManager& manager);
+
+        const std::vector<Scope<Texture>>& pages() const { return _pages; }
+
+    private:
+        TextureAtlasSpec _spec;
+
+        std::vector<std::pair<std::string, std::filesystem::path>> _queued;
+        std::vector<Scope<Texture>> _pages;
+    };
+
+    struct VirtualTextureSpec
+    {
+        /// @brief pixels of image per page, a power of two
+        u32 page_size = 128;
+
+        /// @brief pixels of neighbouring image kept around each page in the cache so bilinear filtering is seamless
+        u32 border = 4;
+
+        /// @brief the physical cache holds cache_pages x cache_pages pages; its size never changes
+        u32 cache_pages = 15;
+
+        /// @brief the feedback pass renders at 1/feedback_scale of the screen size in each direction
+        u32 feedback_scale = 8;
+
+        /// @brief most pages cut and uploaded per update()
+        u32 max_page_loads = 8;
+    };
+
+    struct VirtualTextureStats
+    {
+        u32 resident_pages = 0;
+        u32 cache_pages = 0;
+
+        /// @brief distinct pages the last read back feedback asked for
+        u32 requested_pages = 0;
+        u32 pending_loads = 0;
+
+        /// @brief loaded pages thrown away because every cache page was in use that frame
+        u64 dropped_loads = 0;
+        u64 evictions = 0;
+    };
+
+    /// @brief A texture far larger than what is kept on the GPU. Only the pages the screen actually needs are
+    /// resident, in a fixed size cache texture; an indirection texture maps every page of every mip to the cache page
+    /// to sample (or its closest resident ancestor). Which pages are needed is found by drawing the scene a second
+    /// time, small, into a feedback target that is read back asynchronously.
+    ///
+    /// Shaders #include "virtual_texture.glsl" and call vt_sample(uv), or vt_feedback(uv) in the feedback pass. Each
+    /// frame: begin_feedback(), draw with the feedback shader, end_feedback(), draw normally, then update().
+    struct VirtualTexture : public Resource
+    {
+    public:
+        virtual ~VirtualTexture() = default;
+
+        /// @brief The image must be square with a power of two size, at least one page and at most 256 pages across.
+        /// It is decoded on a worker thread; sampling it shows nothing until update() has made the first page
+        /// resident.
+        static Scope<VirtualTexture> load(const std::filesystem::path& image_filepath, const VirtualTextureSpec& spec = {});
+
+        /// @brief Bind the cache and indirection textures to `cache_slot` and `indirection_slot` (GL_TEXTURE0 + n)
+        /// and set the vt_ uniforms of the bound `shader`
+        virtual void bind(const Shader& shader, unsigned int cache_slot, unsigned int indirection_slot) const = 0;
+
+        /// @brief Redirect drawing into the feedback target until end_feedback()
+        virtual void begin_feedback(i32 screen_width, i32 screen_height) = 0;
+
+        /// @brief Start reading the feedback back and restore the default framebuffer
+        virtual void end_feedback() = 0;
+
+        /// @brief Consume finished feedback read backs, queue loads for missing pages and upload the ones that are
+        /// done, evicting the least recently needed pages to make room. Call once per frame from the render thread.
+        virtual void update() = 0;
+
+        virtual bool is_ready() const = 0;
+        virtual VirtualTextureStats stats() const = 0;
+    };
 } // namespace inx
 
 #endif // __INX_RESOURCES_H__
\ No newline at end of file
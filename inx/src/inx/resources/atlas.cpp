@@ -0,0 +1,254 @@
+#include "../resources.h"
+#include "resources_internal.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+
+namespace inx
+{
+    /// @brief Skyline bottom-left packer: tracks the top edge of everything placed so far as a list of horizontal
+    /// segments and puts each rectangle where its top ends up lowest
+    struct SkylinePacker
+    {
+    public:
+        SkylinePacker(u32 width, u32 height)
+            : _width(width), _height(height)
+        {
+            _skyline.push_back({ 0, 0, width });
+        }
+
+        bool pack(u32 width, u32 height, u32& out_x, u32& out_y)
+        {
+            u32 best_top = std::numeric_limits<u32>::max();
+            u32 best_segment_width = std::numeric_limits<u32>::max();
+            size_t best_index = _skyline.size();
+
+            for (size_t i = 0; i < _skyline.size(); i++)
+            {
+                u32 y;
+                if (!_fit(i, width, height, y)) continue;
+
+                // lowest top wins; on a tie prefer the narrower segment so wide gaps stay free for wide images
+                if (y + height < best_top || (y + height == best_top && _skyline[i].width < best_segment_width))
+                {
+                    best_top = y + height;
+                    best_segment_width = _skyline[i].width;
+                    best_index = i;
+                    out_x = _skyline[i].x;
+                    out_y = y;
+                }
+            }
+
+            if (best_index == _skyline.size()) return false;
+
+            _skyline.insert(_skyline.begin() + best_index, { out_x, out_y + height, width });
+
+            // the new segment covers (parts of) the ones after it
+            for (size_t i = best_index + 1; i < _skyline.size();)
+            {
+                auto& previous = _skyline[i - 1];
+                auto& segment = _skyline[i];
+
+                u32 previous_end = previous.x + previous.width;
+                if (segment.x >= previous_end) break;
+
+                u32 overlap = previous_end - segment.x;
+                if (overlap < segment.width)
+                {
+                    segment.x += overlap;
+                    segment.width -= overlap;
+                    break;
+                }
+
+                _skyline.erase(_skyline.begin() + i);
+            }
+
+            // merge neighbours at the same height
+            for (size_t i = 0; i + 1 < _skyline.size();)
+            {
+                if (_skyline[i].y == _skyline[i + 1].y)
+                {
+                    _skyline[i].width += _skyline[i + 1].width;
+                    _skyline.erase(_skyline.begin() + i + 1);
+                }
+                else i++;
+            }
+
+            return true;
+        }
+
+    private:
+        /// @brief y at which a rect starting at segment `index` would rest, if it fits at all
+        bool _fit(size_t index, u32 width, u32 height, u32& out_y) const
+        {
+            u32 x = _skyline[index].x;
+            if (x + width > _width) return false;
+
+            u32 y = 0;
+            i64 width_left = width;
+            for (size_t i = index; width_left > 0; i++)
+            {
+                y = std::max(y, _skyline[i].y);
+                if (y + height > _height) return false;
+
+                width_left -= _skyline[i].width;
+            }
+
+            out_y = y;
+            return true;
+        }
+
+        struct Segment
+        {
+            u32 x;
+            u32 y;
+            u32 width;
+        };
+
+        u32 _width;
+        u32 _height;
+
+        std::vector<Segment> _skyline;
+    };
+
+    /// @brief copy `image` into an RGBA8 page at (x, y), repeating its outermost pixels `padding` times on every side
+    static void _blit_extruded(std::vector<u8>& page, u32 page_size, const Image& image, u32 x, u32 y, u32 padding)
+    {
+        auto texel = [&image](i64 ix, i64 iy)
+        {
+            ix = std::clamp<i64>(ix, 0, image.width - 1);
+            iy = std::clamp<i64>(iy, 0, image.height - 1);
+
+            const u8* src = image.data() + ((size_t)iy * image.width + ix) * image.channels;
+            switch (image.channels)
+            {
+                case 1: return std::array<u8, 4>{ src[0], src[0], src[0], 255 };
+                case 2: return std::array<u8, 4>{ src[0], src[0], src[0], src[1] };
+                case 3: return std::array<u8, 4>{ src[0], src[1], src[2], 255 };
+                default: return std::array<u8, 4>{ src[0], src[1], src[2], src[3] };
+            }
+        };
+
+        i64 outer_width = image.width + padding * 2;
+        i64 outer_height = image.height + padding * 2;
+        for (i64 row = 0; row < outer_height; row++)
+        {
+            u8* dst = &page[(((size_t)y + row) * page_size + x) * 4];
+            for (i64 column = 0; column < outer_width; column++, dst += 4)
+            {
+                auto rgba = texel(column - padding, row - padding);
+                std::memcpy(dst, rgba.data(), 4);
+            }
+        }
+    }
+
+    TextureAtlas::TextureAtlas(const TextureAtlasSpec& spec)
+        : _spec(spec)
+    {
+    }
+
+    Scope<TextureAtlas> TextureAtlas::load(const TextureAtlasSpec& spec)
+    {
+        return create_scope<TextureAtlas>(spec);
+    }
+
+    void TextureAtlas::add(const std::string& resource_id, const std::filesystem::path& image_filepath)
+    {
+        _queued.emplace_back(resource_id, image_filepath);
+    }
+
+    void TextureAtlas::build(ResourceManager& manager)
+    {
+        if (_queued.empty()) return;
+
+        // decoding dominates, so spread it over the workers
+        std::vector<std::filesystem::path> filepaths;
+        for (const auto& [resource_id, filepath] : _queued)
+            filepaths.push_back(filepath);
+
+        auto images = decode_images(filepaths);
+
+        // tallest first packs a skyline much tighter than arbitrary order
+        std::vector<size_t> order(images.size());
+        for (size_t i = 0; i < order.size(); i++) order[i] = i;
+        std::sort(order.begin(), order.end(), [&images](size_t a, size_t b) { return images[a].height > images[b].height; });
+
+        struct Page
+        {
+            SkylinePacker packer;
+            std::vector<u8> pixels;
+        };
+
+        const u32 page_size = _spec.page_size;
+        const u32 padding = _spec.padding;
+
+        std::vector<Page> pages;
+        std::vector<std::pair<size_t, Scope<AtlasRegion>>> regions;
+
+        for (size_t index : order)
+        {
+            const auto& [resource_id, filepath] = _queued[index];
+            const auto& image = images[index];
+
+            // pages are plain RGBA8, so compressed files can't be packed into them
+            if (!image.valid() || is_compressed(image.format))
+            {
+                std::cerr << "Could not load atlas image: " << filepath.string() << "\n";
+                throw std::runtime_error(std::string("Could not load atlas image: ") + filepath.string());
+            }
+
+            u32 outer_width = image.width + padding * 2;
+            u32 outer_height = image.height + padding * 2;
+            if (outer_width > page_size || outer_height > page_size)
+            {
+                std::cerr << "Atlas image " << filepath.string() << " does not fit in a " << page_size << " page\n";
+                throw std::runtime_error(std::string("Atlas image too large: ") + filepath.string());
+            }
+
+            // first page with room, otherwise start a new one
+            u32 x, y;
+            size_t page_index = 0;
+            for (; page_index < pages.size(); page_index++)
+                if (pages[page_index].packer.pack(outer_width, outer_height, x, y)) break;
+
+            if (page_index == pages.size())
+            {
+                pages.push_back({ SkylinePacker(page_size, page_size), std::vector<u8>((size_t)page_size * page_size * 4, 0) });
+                pages.back().packer.pack(outer_width, outer_height, x, y);
+            }
+
+            _blit_extruded(pages[page_index].pixels, page_size, image, x, y, padding);
+
+            auto region = create_scope<AtlasRegion>();
+            region->uv_min = glm::vec2(x + padding, y + padding) / (float)page_size;
+            region->uv_max = glm::vec2(x + padding + image.width, y + padding + image.height) / (float)page_size;
+            region->width = image.width;
+            region->height = image.height;
+            regions.emplace_back(_pages.size() + page_index, std::move(region));
+        }
+
+        for (const auto& page : pages)
+        {
+            TextureSpec spec;
+            spec.width = page_size;
+            spec.height = page_size;
+            spec.format = ImageFormat::RGBA8;
+            spec.generate_mipmaps = _spec.generate_mipmaps;
+
+            auto texture = Texture::load(spec);
+            texture->data(page.pixels.data(), (u32)page.pixels.size());
+            _pages.push_back(std::move(texture));
+        }
+
+        for (size_t i = 0; i < regions.size(); i++)
+        {
+            auto& [page_index, region] = regions[i];
+            region->texture = _pages[page_index].get();
+            manager.add_resource<AtlasRegion>(_queued[order[i]].first, std::move(region));
+        }
+
+        _queued.clear();
+    }
+} // namespace inx
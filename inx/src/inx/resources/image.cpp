@@ -0,0 +1,160 @@
+#include "resources_internal.h"
+#include "image_kernels.h"
+#include "../core.h"
+
+#include <algorithm>
+#include <cstring>
+#include <latch>
+
+#include <stb/stb_image.h>
+
+namespace inx
+{
+    /// @brief bytes generate_mip_chain() will grow a level 0 of this size to
+    static size_t _mip_chain_size(u32 width, u32 height, u32 channels)
+    {
+        size_t total_size = 0;
+        for (;; width = std::max(1u, width / 2), height = std::max(1u, height / 2))
+        {
+            total_size += (size_t)width * height * channels;
+            if (width == 1 && height == 1) break;
+        }
+
+        return total_size;
+    }
+
+    static Image _decode(const AssetFile& file)
+    {
+        Image image;
+
+        PngInfo png;
+        if (png_info(file.data(), file.size(), png))
+        {
+            image.width = png.width;
+            image.height = png.height;
+            image.channels = png.channels;
+            image.format = png.channels == 1 ? ImageFormat::R8 : ImageFormat::RGBA8;
+
+            // decoded straight into the buffer the mip chain is built in, so neither step reallocates or copies
+            image.pixels.reserve(_mip_chain_size(png.width, png.height, png.channels));
+            image.pixels.resize((size_t)png.width * png.height * png.channels);
+
+            if (decode_png(file.data(), file.size(), png, image.pixels.data())) return image;
+
+            image = Image();
+        }
+
+        // flipped below with the image kernels, which beat stb's per row copy
+        stbi_set_flip_vertically_on_load_thread(false);
+
+        int width, height, channels;
+        unsigned char* data = stbi_load_from_memory(file.data(), (int)file.size(), &width, &height, &channels, 0);
+        if (!data) return image;
+
+        size_t pixel_count = (size_t)width * height;
+
+        image.width = width;
+        image.height = height;
+
+        // GL pads RGB (and grey + alpha, which has no format of its own) out to RGBA anyway, so expand here where
+        // it's vectorised and uploads need no conversion or unpack alignment games
+        if (channels == 1)
+        {
+            image.channels = 1;
+            image.format = ImageFormat::R8;
+            image.pixels.assign(data, data + pixel_count);
+        }
+        else
+        {
+            image.channels = 4;
+            image.format = ImageFormat::RGBA8;
+            image.pixels.resize(pixel_count * 4);
+
+            switch (channels)
+            {
+                case 2: image_kernels::grey_alpha_to_rgba(data, image.pixels.data(), pixel_count); break;
+                case 3: image_kernels::rgb_to_rgba(data, image.pixels.data(), pixel_count); break;
+                default: std::memcpy(image.pixels.data(), data, image.pixels.size()); break;
+            }
+        }
+
+        stbi_image_free(data);
+
+        image_kernels::flip_rows(image.pixels.data(), (size_t)width * image.channels, height);
+        return image;
+    }
+
+    Image decode_image(const std::filesystem::path& filepath)
+    {
+        // already stored the way GL wants it
+        if (filepath.extension() == ".ktx2") return load_ktx2(filepath);
+
+        AssetFile file = AssetPack::open(filepath);
+        if (!file.is_open() || file.size() == 0) return Image();
+
+        // keyed on the contents rather than the path or timestamp, so an edited file can never hit a stale entry.
+        // Packs store the same hash, so files read from one skip hashing altogether
+        u64 content_hash = file.content_hash;
+        if (content_hash == 0) content_hash = hash_fnv1a64(std::string_view((const char*)file.data(), file.size()));
+
+        Image image = load_cached_image(content_hash);
+        if (image.valid()) return image;
+
+        image = _decode(file);
+        if (!image.valid()) return image;
+
+        generate_mip_chain(image);
+        save_cached_image(content_hash, image);
+        return image;
+    }
+
+    std::vector<Image> decode_images(const std::vector<std::filesystem::path>& filepaths)
+    {
+        std::vector<Image> images(filepaths.size());
+        if (filepaths.empty()) return images;
+
+        std::latch decoded((std::ptrdiff_t)filepaths.size());
+        for (size_t i = 0; i < filepaths.size(); i++)
+        {
+            Jobs::submit([&filepaths, &images, &decoded, i]()
+            {
+                images[i] = decode_image(filepaths[i]);
+                decoded.count_down();
+            });
+        }
+        decoded.wait();
+
+        return images;
+    }
+
+    void generate_mip_chain(Image& image)
+    {
+        if (!image.valid() || !image.levels.empty() || is_compressed(image.format)) return;
+
+        const u32 channels = image.channels;
+
+        // lay every level out back to back after level 0
+        size_t total_size = 0;
+        for (u32 width = image.width, height = image.height;; width = std::max(1u, width / 2), height = std::max(1u, height / 2))
+        {
+            size_t size = (size_t)width * height * channels;
+            image.levels.push_back({ total_size, size, width, height });
+            total_size += size;
+
+            if (width == 1 && height == 1) break;
+        }
+
+        image.pixels.resize(total_size);
+
+        for (size_t i = 1; i < image.levels.size(); i++)
+        {
+            const auto& src_level = image.levels[i - 1];
+            const auto& dst_level = image.levels[i];
+
+            const u8* src = image.pixels.data() + src_level.offset;
+            u8* dst = image.pixels.data() + dst_level.offset;
+
+            image_kernels::downsample_2x2(src, src_level.width, src_level.height, dst, dst_level.width, dst_level.height, channels);
+        }
+    }
+} // namespace inx
@@ -0,0 +1,219 @@
+#include "resources_internal.h"
+#include "../core.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace inx
+{
+    /// @brief Header of a decoded image cache file. It is followed by one CachedImageLevel per level, then the pixels
+    /// of every level back to back starting at `data_offset`. Values are native endian; the cache is never shared
+    /// between machines.
+    struct CachedImageHeader
+    {
+        static constexpr u32 MAGIC = 0x49584e49; // "INXI"
+        static constexpr u32 VERSION = 2;
+
+        u32 magic;
+        u32 version;
+        u64 content_hash;
+
+        u32 width;
+        u32 height;
+        u32 channels;
+        u32 format;
+
+        u32 level_count;
+        u32 data_offset;
+        u64 data_size;
+    };
+
+    struct CachedImageLevel
+    {
+        u64 offset;
+        u64 size;
+        u32 width;
+        u32 height;
+    };
+
+    static_assert(sizeof(CachedImageHeader) == 48);
+    static_assert(sizeof(CachedImageLevel) == 24);
+
+    /// @brief pixel data starts on this boundary so it can be copied from the mapping with aligned loads
+    static constexpr u32 DATA_ALIGNMENT = 16;
+
+    /// @brief more levels than a 2^31 pixel wide image has can only come from a corrupt file
+    static constexpr u32 MAX_LEVELS = 32;
+
+    /// @brief Whenever an entry is written the cache is trimmed back under this size, least recently used entries
+    /// first. Hits refresh an entry's modification time, which is what "used" goes by.
+    static constexpr u64 CACHE_BUDGET = 512ull * 1024 * 1024;
+
+    static std::filesystem::path _cache_directory()
+    {
+        return std::filesystem::path(CACHE_PATH) / "images";
+    }
+
+    static std::filesystem::path _cache_path(u64 content_hash)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.img", (unsigned long long)content_hash);
+        return _cache_directory() / name;
+    }
+
+    /// @brief channel count each cacheable format must have; the cache only ever holds decoded 8 bit images
+    static u32 _format_channels(ImageFormat format)
+    {
+        switch (format)
+        {
+            case ImageFormat::R8:       return 1;
+            case ImageFormat::RGB8:     return 3;
+            case ImageFormat::RGBA8:    return 4;
+        }
+
+        return 0;
+    }
+
+    static void _trim_cache()
+    {
+        struct Entry
+        {
+            std::filesystem::path path;
+            std::filesystem::file_time_type time;
+            u64 size;
+        };
+
+        std::error_code error;
+        std::vector<Entry> entries;
+        u64 total = 0;
+
+        for (const auto& item : std::filesystem::directory_iterator(_cache_directory(), error))
+        {
+            if (item.path().extension() != ".img") continue;
+
+            Entry entry = { item.path(), item.last_write_time(error), item.file_size(error) };
+            if (error) continue;
+
+            total += entry.size;
+            entries.push_back(std::move(entry));
+        }
+
+        if (total <= CACHE_BUDGET) return;
+
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.time < b.time; });
+        for (const auto& entry : entries)
+        {
+            if (total <= CACHE_BUDGET) break;
+
+            // an entry another thread has mapped may refuse to go on some platforms; it's tried again next time
+            if (std::filesystem::remove(entry.path, error)) total -= entry.size;
+        }
+    }
+
+    Image load_cached_image(u64 content_hash)
+    {
+        Image image;
+
+        const auto path = _cache_path(content_hash);
+        auto file = create_ref<MappedFile>(path);
+        if (!file->is_open() || file->size() < sizeof(CachedImageHeader)) return image;
+
+        // anything that doesn't check out (a different version, a truncated write, a corrupt file) is just a miss.
+        // Every end is compared by subtraction so a huge offset can't wrap around and pass.
+        const u64 file_size = file->size();
+        const auto* header = (const CachedImageHeader*)file->data();
+        if (header->magic != CachedImageHeader::MAGIC || header->version != CachedImageHeader::VERSION) return image;
+        if (header->content_hash != content_hash || header->level_count == 0 || header->level_count > MAX_LEVELS) return image;
+        if (header->width == 0 || header->height == 0 || header->channels != _format_channels((ImageFormat)header->format)) return image;
+
+        size_t levels_end = sizeof(CachedImageHeader) + (size_t)header->level_count * sizeof(CachedImageLevel);
+        if (header->data_offset < levels_end || header->data_offset > file_size || header->data_size > file_size - header->data_offset) return image;
+
+        // the upload reads width * height * channels for every level, so that's exactly what each must hold
+        const auto* levels = (const CachedImageLevel*)(file->data() + sizeof(CachedImageHeader));
+        for (u32 i = 0; i < header->level_count; i++)
+        {
+            const auto& level = levels[i];
+            if (level.width != std::max(1u, header->width >> i) || level.height != std::max(1u, header->height >> i)) return Image();
+            if (level.size != (u64)level.width * level.height * header->channels) return Image();
+            if (level.offset > header->data_size || level.size > header->data_size - level.offset) return Image();
+
+            image.levels.push_back({ (size_t)level.offset, (size_t)level.size, level.width, level.height });
+        }
+
+        // counts as a use for _trim_cache
+        std::error_code error;
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+
+        image.width = header->width;
+        image.height = header->height;
+        image.channels = header->channels;
+        image.format = (ImageFormat)header->format;
+
+        image.mapped = file->data() + header->data_offset;
+        image.mapped_size = (size_t)header->data_size;
+        image.mapping = std::move(file);
+
+        return image;
+    }
+
+    void save_cached_image(u64 content_hash, const Image& image)
+    {
+        if (!image.valid()) return;
+
+        std::vector<CachedImageLevel> levels;
+        if (image.levels.empty()) levels.push_back({ 0, image.size(), image.width, image.height });
+        for (const auto& level : image.levels)
+            levels.push_back({ level.offset, level.size, level.width, level.height });
+
+        size_t levels_end = sizeof(CachedImageHeader) + levels.size() * sizeof(CachedImageLevel);
+        u32 data_offset = (u32)((levels_end + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT);
+
+        CachedImageHeader header = {
+            CachedImageHeader::MAGIC, CachedImageHeader::VERSION, content_hash,
+            image.width, image.height, image.channels, (u32)image.format,
+            (u32)levels.size(), data_offset, image.size(),
+        };
+
+        auto path = _cache_path(content_hash);
+
+        std::error_code error;
+        std::filesystem::create_directories(path.parent_path(), error);
+
+        // written under a name of its own and renamed into place, so a reader (or another thread decoding the same
+        // file) never maps a half written entry
+        auto temp_path = path;
+        temp_path += "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+
+        {
+            std::ofstream fstream(temp_path, std::ios::binary | std::ios::trunc);
+            if (!fstream) return;
+
+            const char padding[DATA_ALIGNMENT] = {};
+            fstream.write((const char*)&header, sizeof(header));
+            fstream.write((const char*)levels.data(), levels.size() * sizeof(CachedImageLevel));
+            fstream.write(padding, data_offset - levels_end);
+            fstream.write((const char*)image.data(), image.size());
+
+            if (!fstream)
+            {
+                fstream.close();
+                std::filesystem::remove(temp_path, error);
+                return;
+            }
+        }
+
+        std::filesystem::rename(temp_path, path, error);
+        if (error)
+        {
+            std::filesystem::remove(temp_path, error);
+            return;
+        }
+
+        _trim_cache();
+    }
+} // namespace inx
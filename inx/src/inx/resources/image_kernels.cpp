@@ -0,0 +1,208 @@
+#include "image_kernels.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__AVX2__)
+#define INX_IMAGE_AVX2
+#define INX_IMAGE_SSE2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define INX_IMAGE_SSE2
+#include <emmintrin.h>
+#endif
+
+// pshufb makes RGB expansion a single shuffle; MSVC never defines __SSSE3__, but AVX2 implies it
+#if defined(__SSSE3__) || defined(INX_IMAGE_AVX2)
+#define INX_IMAGE_SSSE3
+#include <tmmintrin.h>
+#endif
+
+namespace inx
+{
+    namespace image_kernels
+    {
+        void flip_rows(u8* pixels, size_t row_bytes, u32 height)
+        {
+            for (u32 y = 0; y < height / 2; y++)
+            {
+                u8* top = pixels + (size_t)y * row_bytes;
+                u8* bottom = pixels + (size_t)(height - 1 - y) * row_bytes;
+
+                size_t i = 0;
+#if defined(INX_IMAGE_AVX2)
+                for (; i + 32 <= row_bytes; i += 32)
+                {
+                    __m256i a = _mm256_loadu_si256((const __m256i*)(top + i));
+                    __m256i b = _mm256_loadu_si256((const __m256i*)(bottom + i));
+                    _mm256_storeu_si256((__m256i*)(top + i), b);
+                    _mm256_storeu_si256((__m256i*)(bottom + i), a);
+                }
+#endif
+#if defined(INX_IMAGE_SSE2)
+                for (; i + 16 <= row_bytes; i += 16)
+                {
+                    __m128i a = _mm_loadu_si128((const __m128i*)(top + i));
+                    __m128i b = _mm_loadu_si128((const __m128i*)(bottom + i));
+                    _mm_storeu_si128((__m128i*)(top + i), b);
+                    _mm_storeu_si128((__m128i*)(bottom + i), a);
+                }
+#endif
+                for (; i < row_bytes; i++)
+                    std::swap(top[i], bottom[i]);
+            }
+        }
+
+        void rgb_to_rgba(const u8* src, u8* dst, size_t pixel_count)
+        {
+            size_t i = 0;
+
+#if defined(INX_IMAGE_SSSE3)
+            // 4 pixels per shuffle; each load reads 16 bytes for 12, so stop while a full load still fits
+            const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+            const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+
+#if defined(INX_IMAGE_AVX2)
+            const __m256i shuffle8 = _mm256_broadcastsi128_si256(shuffle);
+            const __m256i alpha8 = _mm256_set1_epi32((int)0xff000000);
+            for (; i + 10 <= pixel_count; i += 8)
+            {
+                __m128i lo = _mm_loadu_si128((const __m128i*)(src + i * 3));
+                __m128i hi = _mm_loadu_si128((const __m128i*)(src + i * 3 + 12));
+                __m256i rgb = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+                __m256i rgba = _mm256_or_si256(_mm256_shuffle_epi8(rgb, shuffle8), alpha8);
+                _mm256_storeu_si256((__m256i*)(dst + i * 4), rgba);
+            }
+#endif
+            for (; i + 6 <= pixel_count; i += 4)
+            {
+                __m128i rgb = _mm_loadu_si128((const __m128i*)(src + i * 3));
+                _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha));
+            }
+#endif
+            for (; i < pixel_count; i++)
+            {
+                dst[i * 4 + 0] = src[i * 3 + 0];
+                dst[i * 4 + 1] = src[i * 3 + 1];
+                dst[i * 4 + 2] = src[i * 3 + 2];
+                dst[i * 4 + 3] = 255;
+            }
+        }
+
+        void grey_alpha_to_rgba(const u8* src, u8* dst, size_t pixel_count)
+        {
+            size_t i = 0;
+
+#if defined(INX_IMAGE_SSE2)
+            // 8 pixels per iteration: widen each grey/alpha pair to grey/grey/grey/alpha
+            const __m128i grey_mask = _mm_set1_epi16(0x00ff);
+            for (; i + 8 <= pixel_count; i += 8)
+            {
+                __m128i ga = _mm_loadu_si128((const __m128i*)(src + i * 2));
+                __m128i grey = _mm_and_si128(ga, grey_mask);
+                __m128i gg = _mm_or_si128(grey, _mm_slli_epi16(grey, 8));
+                _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_unpacklo_epi16(gg, ga));
+                _mm_storeu_si128((__m128i*)(dst + i * 4 + 16), _mm_unpackhi_epi16(gg, ga));
+            }
+#endif
+            for (; i < pixel_count; i++)
+            {
+                dst[i * 4 + 0] = dst[i * 4 + 1] = dst[i * 4 + 2] = src[i * 2];
+                dst[i * 4 + 3] = src[i * 2 + 1];
+            }
+        }
+
+        /// @brief Average 2x2 blocks of two full source rows into one destination row; the source is at least 2 wide
+        static void _downsample_row(const u8* row0, const u8* row1, u8* dst, u32 dst_width, u32 channels)
+        {
+            u32 x = 0;
+
+#if defined(INX_IMAGE_SSE2)
+            if (channels == 4)
+            {
+#if defined(INX_IMAGE_AVX2)
+                const __m256i zero8 = _mm256_setzero_si256();
+                const __m256i two8 = _mm256_set1_epi16(2);
+                for (; x + 4 <= dst_width; x += 4)
+                {
+                    __m256i r0 = _mm256_loadu_si256((const __m256i*)(row0 + x * 8));
+                    __m256i r1 = _mm256_loadu_si256((const __m256i*)(row1 + x * 8));
+
+                    // per 128 bit lane: lo holds pixels 0,1 (4,5), hi pixels 2,3 (6,7), rows already summed
+                    __m256i lo = _mm256_add_epi16(_mm256_unpacklo_epi8(r0, zero8), _mm256_unpacklo_epi8(r1, zero8));
+                    __m256i hi = _mm256_add_epi16(_mm256_unpackhi_epi8(r0, zero8), _mm256_unpackhi_epi8(r1, zero8));
+                    __m256i sum = _mm256_add_epi16(_mm256_unpacklo_epi64(lo, hi), _mm256_unpackhi_epi64(lo, hi));
+                    sum = _mm256_srli_epi16(_mm256_add_epi16(sum, two8), 2);
+
+                    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(sum, sum), 0x08);
+                    _mm_storeu_si128((__m128i*)(dst + x * 4), _mm256_castsi256_si128(packed));
+                }
+#endif
+                const __m128i zero = _mm_setzero_si128();
+                const __m128i two = _mm_set1_epi16(2);
+                for (; x + 2 <= dst_width; x += 2)
+                {
+                    __m128i r0 = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+                    __m128i r1 = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+
+                    __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(r0, zero), _mm_unpacklo_epi8(r1, zero));
+                    __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(r0, zero), _mm_unpackhi_epi8(r1, zero));
+                    __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+                    sum = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+
+                    _mm_storel_epi64((__m128i*)(dst + x * 4), _mm_packus_epi16(sum, sum));
+                }
+            }
+            else if (channels == 1)
+            {
+                // 8 output pixels per iteration: even and odd bytes of each row summed as 16 bit lanes
+                const __m128i even = _mm_set1_epi16(0x00ff);
+                const __m128i two = _mm_set1_epi16(2);
+                for (; x + 8 <= dst_width; x += 8)
+                {
+                    __m128i r0 = _mm_loadu_si128((const __m128i*)(row0 + x * 2));
+                    __m128i r1 = _mm_loadu_si128((const __m128i*)(row1 + x * 2));
+
+                    __m128i sum = _mm_add_epi16(_mm_and_si128(r0, even), _mm_srli_epi16(r0, 8));
+                    sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_and_si128(r1, even), _mm_srli_epi16(r1, 8)));
+                    sum = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+
+                    _mm_storel_epi64((__m128i*)(dst + x), _mm_packus_epi16(sum, sum));
+                }
+            }
+#endif
+            for (; x < dst_width; x++)
+            {
+                const u8* a = row0 + (size_t)x * 2 * channels;
+                const u8* b = row1 + (size_t)x * 2 * channels;
+
+                u8* out = dst + (size_t)x * channels;
+                for (u32 channel = 0; channel < channels; channel++)
+                    out[channel] = (u8)((a[channel] + a[channel + channels] + b[channel] + b[channel + channels] + 2) / 4);
+            }
+        }
+
+        void downsample_2x2(const u8* src, u32 src_width, u32 src_height, u8* dst, u32 dst_width, u32 dst_height, u32 channels)
+        {
+            const size_t src_row = (size_t)src_width * channels;
+            const size_t dst_row = (size_t)dst_width * channels;
+
+            for (u32 y = 0; y < dst_height; y++)
+            {
+                const u8* row0 = src + std::min(y * 2, src_height - 1) * src_row;
+                const u8* row1 = src + std::min(y * 2 + 1, src_height - 1) * src_row;
+                u8* out = dst + y * dst_row;
+
+                if (src_width >= 2)
+                {
+                    _downsample_row(row0, row1, out, dst_width, channels);
+                    continue;
+                }
+
+                // a single column averages with itself
+                for (u32 channel = 0; channel < channels; channel++)
+                    out[channel] = (u8)((row0[channel] * 2 + row1[channel] * 2 + 2) / 4);
+            }
+        }
+    } // namespace image_kernels
+} // namespace inx
@@ -0,0 +1,29 @@
+#ifndef __INX_IMAGE_KERNELS_H__
+#define __INX_IMAGE_KERNELS_H__
+
+#include "../types.h"
+
+namespace inx
+{
+    /// @brief Pixel loops the texture loader spends most of its time in, vectorised with SSE2 on every x64 build
+    /// and AVX2 when the compiler targets it (INX_AVX2), with scalar fallbacks elsewhere. Every path gives bit
+    /// identical results. Pixels are 8 bits per channel, rows tightly packed.
+    namespace image_kernels
+    {
+        /// @brief Reverse the order of `height` rows of `row_bytes` each, in place
+        void flip_rows(u8* pixels, size_t row_bytes, u32 height);
+
+        /// @brief Expand RGB to RGBA with opaque alpha; `src` and `dst` must not overlap. The vector path needs SSSE3
+        /// (pshufb), so without it (or INX_AVX2) this runs scalar.
+        void rgb_to_rgba(const u8* src, u8* dst, size_t pixel_count);
+
+        /// @brief Expand grey + alpha to RGBA; `src` and `dst` must not overlap
+        void grey_alpha_to_rgba(const u8* src, u8* dst, size_t pixel_count);
+
+        /// @brief Box filter one level into the next: every destination pixel averages a 2x2 block, rounding to
+        /// nearest. A source dimension of 1 is clamped rather than halved.
+        void downsample_2x2(const u8* src, u32 src_width, u32 src_height, u8* dst, u32 dst_width, u32 dst_height, u32 channels);
+    } // namespace image_kernels
+} // namespace inx
+
+#endif // __INX_IMAGE_KERNELS_H__
@@ -0,0 +1,214 @@
+#include "resources_internal.h"
+#include "image_kernels.h"
+#include "../core.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <iostream>
+
+namespace inx
+{
+    static constexpr u8 KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+    struct KTX2Header
+    {
+        u8 identifier[12];
+        u32 vk_format;
+        u32 type_size;
+        u32 pixel_width;
+        u32 pixel_height;
+        u32 pixel_depth;
+        u32 layer_count;
+        u32 face_count;
+        u32 level_count;
+        u32 supercompression_scheme;
+
+        u32 dfd_byte_offset;
+        u32 dfd_byte_length;
+        u32 kvd_byte_offset;
+        u32 kvd_byte_length;
+        u64 sgd_byte_offset;
+        u64 sgd_byte_length;
+    };
+
+    static_assert(sizeof(KTX2Header) == 80);
+
+    struct KTX2Level
+    {
+        u64 byte_offset;
+        u64 byte_length;
+        u64 uncompressed_byte_length;
+    };
+
+    /// @brief the VkFormat values we can upload; sRGB variants load as their linear counterpart like every other texture
+    static bool _ktx2_format(u32 vk_format, ImageFormat& format, u32& channels)
+    {
+        switch (vk_format)
+        {
+            case 9:   /* R8_UNORM */                    format = ImageFormat::R8;           channels = 1; return true;
+            case 23:  /* R8G8B8_UNORM */
+            case 29:  /* R8G8B8_SRGB */                 format = ImageFormat::RGB8;         channels = 3; return true;
+            case 37:  /* R8G8B8A8_UNORM */
+            case 43:  /* R8G8B8A8_SRGB */               format = ImageFormat::RGBA8;        channels = 4; return true;
+            case 131: /* BC1_RGB_UNORM_BLOCK */
+            case 132: /* BC1_RGB_SRGB_BLOCK */          format = ImageFormat::BC1_RGB;      channels = 3; return true;
+            case 133: /* BC1_RGBA_UNORM_BLOCK */
+            case 134: /* BC1_RGBA_SRGB_BLOCK */         format = ImageFormat::BC1;          channels = 4; return true;
+            case 137: /* BC3_UNORM_BLOCK */
+            case 138: /* BC3_SRGB_BLOCK */              format = ImageFormat::BC3;          channels = 4; return true;
+            case 145: /* BC7_UNORM_BLOCK */
+            case 146: /* BC7_SRGB_BLOCK */              format = ImageFormat::BC7;          channels = 4; return true;
+            case 147: /* ETC2_R8G8B8_UNORM_BLOCK */
+            case 148: /* ETC2_R8G8B8_SRGB_BLOCK */      format = ImageFormat::ETC2_RGB8;    channels = 3; return true;
+            case 151: /* ETC2_R8G8B8A8_UNORM_BLOCK */
+            case 152: /* ETC2_R8G8B8A8_SRGB_BLOCK */    format = ImageFormat::ETC2_RGBA8;   channels = 4; return true;
+        }
+
+        return false;
+    }
+
+    /// @brief bytes a level of this size must hold; block compressed formats round up to whole 4x4 blocks
+    static u64 _ktx2_level_size(ImageFormat format, u32 channels, u32 width, u32 height)
+    {
+        u64 blocks = (((u64)width + 3) / 4) * (((u64)height + 3) / 4);
+        switch (format)
+        {
+            case ImageFormat::BC1_RGB:
+            case ImageFormat::BC1:
+            case ImageFormat::ETC2_RGB8:    return blocks * 8;
+            case ImageFormat::BC3:
+            case ImageFormat::BC7:
+            case ImageFormat::ETC2_RGBA8:   return blocks * 16;
+        }
+
+        return (u64)width * height * channels;
+    }
+
+    /// @brief Whether rows are stored top row first, per the KTXorientation key/value entry. KTX2 defaults to "rd"
+    /// (top-down) when the entry is missing; bottom-up files say "ru".
+    static bool _ktx2_top_down(const KTX2Header& header, const u8* data, size_t file_size)
+    {
+        if (header.kvd_byte_offset > file_size || header.kvd_byte_length > file_size - header.kvd_byte_offset) return true;
+
+        // each entry is a u32 length, then a NUL terminated key and its value, padded to 4 bytes
+        const u8* kvd = data + header.kvd_byte_offset;
+        u32 offset = 0;
+        while (header.kvd_byte_length - offset >= sizeof(u32))
+        {
+            u32 length;
+            std::memcpy(&length, kvd + offset, sizeof(length));
+            offset += sizeof(u32);
+            if (length > header.kvd_byte_length - offset) break;
+
+            std::string_view entry((const char*)kvd + offset, length);
+            constexpr std::string_view key = "KTXorientation";
+            if (entry.size() > key.size() + 1 && entry.substr(0, key.size()) == key && entry[key.size()] == '\0')
+                return entry.size() < key.size() + 3 || entry[key.size() + 2] != 'u';
+
+            offset += (length + 3) & ~3u;
+        }
+
+        return true;
+    }
+
+    Image load_ktx2(const std::filesystem::path& filepath)
+    {
+        Image image;
+
+        // levels are copied straight out of the mapping (or pack) into the order GL wants them
+        AssetFile data = AssetPack::open(filepath);
+        if (!data.is_open()) return image;
+
+        size_t file_size = data.size();
+
+        KTX2Header header;
+        if (file_size < sizeof(header)) return image;
+        std::memcpy(&header, data.data(), sizeof(header));
+
+        if (std::memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+        {
+            std::cerr << "Not a KTX2 file: " << filepath.string() << "\n";
+            return image;
+        }
+
+        // only plain 2D textures; arrays, cubemaps and 3D textures need their own resource types
+        if (header.pixel_depth > 1 || header.layer_count > 1 || header.face_count != 1)
+        {
+            std::cerr << "Unsupported KTX2 texture type (only 2D is supported): " << filepath.string() << "\n";
+            return image;
+        }
+
+        if (header.supercompression_scheme != 0)
+        {
+            std::cerr << "Unsupported KTX2 supercompression scheme " << header.supercompression_scheme << ": " << filepath.string() << "\n";
+            return image;
+        }
+
+        if (!_ktx2_format(header.vk_format, image.format, image.channels))
+        {
+            std::cerr << "Unsupported KTX2 format " << header.vk_format << ": " << filepath.string() << "\n";
+            return image;
+        }
+
+        // a level count of 0 asks the loader to generate mips, which we do at upload time like any other image. More
+        // levels than the full chain has can only come from a corrupt file.
+        u32 level_count = std::max(1u, header.level_count);
+        if (header.pixel_width == 0 || header.pixel_height == 0) return image;
+        if (level_count > (u32)std::bit_width(std::max(header.pixel_width, header.pixel_height))) return image;
+        if ((file_size - sizeof(KTX2Header)) / sizeof(KTX2Level) < level_count) return image;
+
+        image.width = header.pixel_width;
+        image.height = header.pixel_height;
+
+        // the level index lists the base level first, even though the data is stored smallest first
+        std::vector<KTX2Level> levels(level_count);
+        std::memcpy(levels.data(), data.data() + sizeof(KTX2Header), level_count * sizeof(KTX2Level));
+
+        // the upload reads exactly the size of each level, so that's what each must hold. Every end is compared by
+        // subtraction so a huge offset can't wrap around and pass.
+        size_t total_size = 0;
+        for (u32 i = 0; i < level_count; i++)
+        {
+            const auto& level = levels[i];
+            u64 expected = _ktx2_level_size(image.format, image.channels, std::max(1u, image.width >> i), std::max(1u, image.height >> i));
+            if (level.byte_length != expected || level.byte_offset > file_size || level.byte_length > file_size - level.byte_offset)
+            {
+                std::cerr << "Corrupt KTX2 level " << i << ": " << filepath.string() << "\n";
+                return Image();
+            }
+
+            total_size += (size_t)level.byte_length;
+        }
+
+        image.pixels.resize(total_size);
+        image.levels.reserve(level_count);
+
+        size_t offset = 0;
+        for (u32 i = 0; i < level_count; i++)
+        {
+            const auto& level = levels[i];
+            std::memcpy(image.pixels.data() + offset, data.data() + level.byte_offset, level.byte_length);
+
+            image.levels.push_back({ offset, (size_t)level.byte_length, std::max(1u, image.width >> i), std::max(1u, image.height >> i) });
+            offset += level.byte_length;
+        }
+
+        // GL samples bottom row first, like every other loader produces. Block compressed data can't be flipped by
+        // moving rows around, so those files have to be authored bottom-up (toktx --lower_left_maps_to_s0t0).
+        if (_ktx2_top_down(header, data.data(), file_size))
+        {
+            if (is_compressed(image.format))
+            {
+                std::cerr << "Compressed KTX2 file is stored top-down and will sample upside down: " << filepath.string() << "\n";
+            }
+            else
+            {
+                for (const auto& level : image.levels)
+                    image_kernels::flip_rows(image.pixels.data() + level.offset, (size_t)level.width * image.channels, level.height);
+            }
+        }
+
+        return image;
+    }
+} // namespace inx
@@ -0,0 +1,53 @@
+#include "../resources.h"
+
+#include <glad/glad.h>
+
+namespace inx
+{
+    Scope<Material> Material::create(ResourceManager& manager, const MaterialSpec& spec)
+    {
+        auto result = create_scope<Material>();
+        result->_shader = &manager.get_resource(spec.shader);
+
+        result->_textures.reserve(spec.textures.size());
+        for (const auto& [sampler, texture] : spec.textures)
+            result->_textures.emplace_back(sampler, &manager.get_resource(texture));
+
+        return result;
+    }
+
+    Scope<Material> Material::finalise(ResourceManager& manager, MaterialSpec&& spec)
+    {
+        return create(manager, spec);
+    }
+
+    std::vector<ResourceDependency> Material::dependencies(const MaterialSpec& spec)
+    {
+        std::vector<ResourceDependency> result;
+        result.reserve(spec.textures.size() + 1);
+
+        result.emplace_back(spec.shader);
+        for (const auto& [sampler, texture] : spec.textures)
+            result.emplace_back(texture);
+
+        return result;
+    }
+
+    void Material::bind() const
+    {
+        _shader->bind();
+
+        if (_samplers.size() != _textures.size())
+        {
+            _samplers.clear();
+            for (const auto& [sampler, texture] : _textures)
+                _samplers.push_back(_shader->uniform(sampler));
+        }
+
+        for (u32 i = 0; i < (u32)_textures.size(); i++)
+        {
+            _shader->set_int(_samplers[i], (int)i);
+            _textures[i].second->bind(GL_TEXTURE0 + i);
+        }
+    }
+} // namespace inx
@@ -0,0 +1,626 @@
+#include "resources_internal.h"
+#include "image_kernels.h"
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define INX_PNG_SSE2
+#include <emmintrin.h>
+#endif
+
+// Only what large assets actually use is handled here: 8 bit, non interlaced grey, grey + alpha, RGB, RGBA and
+// palette images. png_info() turns everything else away so decode_image() hands it to stb_image. Like the rest of the
+// loader this assumes a little endian host.
+
+namespace inx
+{
+    static constexpr u8 PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+    /// @brief stb_image's limits (STBI_MAX_DIMENSIONS and its int sized buffers), so anything past them is refused up
+    /// front rather than failing an allocation on a worker, and both decoders agree on what loads
+    static constexpr u32 PNG_MAX_DIMENSION = 1u << 24;
+    static constexpr u64 PNG_MAX_BYTES = 0x7fffffff;
+
+    enum PngColourType : u8
+    {
+        PNG_GREY = 0, PNG_RGB = 2, PNG_PALETTE = 3, PNG_GREY_ALPHA = 4, PNG_RGBA = 6,
+    };
+
+    static u32 _read_be32(const u8* data)
+    {
+        return ((u32)data[0] << 24) | ((u32)data[1] << 16) | ((u32)data[2] << 8) | data[3];
+    }
+
+    static u32 _png_bpp(u8 colour_type)
+    {
+        switch(colour_type)
+        {
+            case PNG_GREY:          return 1;
+            case PNG_PALETTE:       return 1;
+            case PNG_GREY_ALPHA:    return 2;
+            case PNG_RGB:           return 3;
+            case PNG_RGBA:          return 4;
+        }
+
+        return 0;
+    }
+
+    /// @brief Walk the chunks, calling `visit(type, data, length)` for each; false if they run past the end
+    template<typename F>
+    static bool _for_each_chunk(const u8* data, size_t size, F&& visit)
+    {
+        size_t pos = sizeof(PNG_SIGNATURE);
+        while (pos + 12 <= size)
+        {
+            u32 length = _read_be32(data + pos);
+            const u8* type = data + pos + 4;
+            if (length > size - pos - 12) return false;
+
+            // CRCs aren't checked; a corrupt file fails to inflate or unfilter instead
+            if (!visit(type, data + pos + 8, length)) return true;
+            if (std::memcmp(type, "IEND", 4) == 0) return true;
+
+            pos += 12 + (size_t)length;
+        }
+
+        return false;
+    }
+
+    bool png_info(const u8* data, size_t size, PngInfo& info)
+    {
+        if (size < 8 + 25 || std::memcmp(data, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) != 0) return false;
+
+        const u8* ihdr = data + 8;
+        if (_read_be32(ihdr) != 13 || std::memcmp(ihdr + 4, "IHDR", 4) != 0) return false;
+
+        info.width = _read_be32(ihdr + 8);
+        info.height = _read_be32(ihdr + 12);
+        u8 bit_depth = ihdr[16];
+        info.colour_type = ihdr[17];
+        u8 compression = ihdr[18], filter = ihdr[19], interlace = ihdr[20];
+
+        if (info.width == 0 || info.height == 0 || info.width > PNG_MAX_DIMENSION || info.height > PNG_MAX_DIMENSION) return false;
+
+        // decoded rows are at most 4 bytes a pixel plus a filter byte each, and the image is expanded to 4 channels
+        if (((u64)info.width * 4 + 1) * info.height > PNG_MAX_BYTES) return false;
+        if (bit_depth != 8 || compression != 0 || filter != 0 || interlace != 0 || _png_bpp(info.colour_type) == 0) return false;
+
+        bool has_palette = false, colour_key = false;
+        bool complete = _for_each_chunk(data, size, [&](const u8* type, const u8*, u32)
+        {
+            if (std::memcmp(type, "PLTE", 4) == 0) has_palette = true;
+            if (std::memcmp(type, "tRNS", 4) == 0 && info.colour_type != PNG_PALETTE) colour_key = true;
+            return true;
+        });
+
+        // colour keyed transparency is rare enough to leave to stb
+        if (!complete || colour_key || (info.colour_type == PNG_PALETTE && !has_palette)) return false;
+
+        info.channels = info.colour_type == PNG_GREY ? 1 : 4;
+        return true;
+    }
+
+    // inflate (RFC 1951) behind a zlib header (RFC 1950)
+
+    struct PngBitReader
+    {
+    public:
+        const u8* data;
+        size_t size;
+        size_t pos = 0;
+
+        /// @brief bits above `bit_count` may hold the start of bytes not counted yet; they're always the same bits
+        /// the next refill would put there, so OR-ing them in again is harmless
+        u64 buffer = 0;
+        u32 bit_count = 0;
+
+        /// @brief top up to at least 56 bits; past the end of the data zeros are shifted in
+        void refill()
+        {
+            if (pos + 8 <= size)
+            {
+                u64 word;
+                std::memcpy(&word, data + pos, 8);
+                buffer |= word << bit_count;
+                pos += (63 - bit_count) >> 3;
+                bit_count |= 56;
+                return;
+            }
+
+            while (bit_count <= 56)
+            {
+                u64 byte = pos < size ? data[pos] : 0;
+                buffer |= byte << bit_count;
+                bit_count += 8;
+                pos++;
+            }
+        }
+
+        u32 bits(u32 count)
+        {
+            u32 value = (u32)(buffer & ((1ull << count) - 1));
+            consume(count);
+            return value;
+        }
+
+        void consume(u32 count)
+        {
+            buffer >>= count;
+            bit_count -= count;
+        }
+
+        /// @brief true once more has been consumed than the data holds
+        bool overrun() const { return pos - (bit_count >> 3) > size; }
+    };
+
+    struct PngHuffman
+    {
+    public:
+        constexpr static const u32 FAST_BITS = 10;
+        constexpr static const u32 INVALID = 0xffff;
+
+        /// @brief symbol | length << 9 for every code of FAST_BITS or fewer, indexed by the next FAST_BITS input bits;
+        /// 0 means the code is longer
+        std::array<u16, 1 << FAST_BITS> fast;
+
+        // canonical decoding for longer codes, on the next 16 bits reversed
+        std::array<u32, 17> max_code;
+        std::array<u16, 16> first_code;
+        std::array<u16, 16> first_symbol;
+        std::array<u16, 288> symbols;
+    };
+
+    static u32 _reverse16(u32 bits)
+    {
+        bits = ((bits & 0xaaaa) >> 1) | ((bits & 0x5555) << 1);
+        bits = ((bits & 0xcccc) >> 2) | ((bits & 0x3333) << 2);
+        bits = ((bits & 0xf0f0) >> 4) | ((bits & 0x0f0f) << 4);
+        bits = ((bits & 0xff00) >> 8) | ((bits & 0x00ff) << 8);
+        return bits;
+    }
+
+    static bool _build_huffman(PngHuffman& huffman, const u8* lengths, u32 count)
+    {
+        std::array<u32, 16> counts{};
+        for (u32 i = 0; i < count; i++)
+            counts[lengths[i]]++;
+        counts[0] = 0;
+
+        huffman.fast.fill(0);
+
+        std::array<u32, 16> next_code{};
+        u32 code = 0, symbol = 0;
+        for (u32 length = 1; length < 16; length++)
+        {
+            next_code[length] = code;
+            huffman.first_code[length] = (u16)code;
+            huffman.first_symbol[length] = (u16)symbol;
+
+            code += counts[length];
+            if (counts[length] && code - 1 >= (1u << length)) return false;
+
+            huffman.max_code[length] = code << (16 - length);
+            code <<= 1;
+            symbol += counts[length];
+        }
+        huffman.max_code[16] = 0x10000;
+
+        for (u32 i = 0; i < count; i++)
+        {
+            u32 length = lengths[i];
+            if (length == 0) continue;
+
+            u32 symbol_code = next_code[length]++;
+            huffman.symbols[huffman.first_symbol[length] + (symbol_code - huffman.first_code[length])] = (u16)i;
+
+            if (length <= PngHuffman::FAST_BITS)
+            { // the stream holds codes most significant bit first, so the table is indexed by them reversed
+                for (u32 j = _reverse16(symbol_code) >> (16 - length); j < (1u << PngHuffman::FAST_BITS); j += 1u << length)
+                    huffman.fast[j] = (u16)(i | (length << 9));
+            }
+        }
+
+        return true;
+    }
+
+    /// @brief The reader must hold at least 15 bits
+    static u32 _decode_symbol(PngBitReader& reader, const PngHuffman& huffman)
+    {
+        u32 entry = huffman.fast[reader.buffer & ((1u << PngHuffman::FAST_BITS) - 1)];
+        if (entry)
+        {
+            reader.consume(entry >> 9);
+            return entry & 511;
+        }
+
+        u32 k = _reverse16((u32)(reader.buffer & 0xffff));
+        u32 length = PngHuffman::FAST_BITS + 1;
+        while (k >= huffman.max_code[length])
+            length++;
+        if (length >= 16) return PngHuffman::INVALID;
+
+        reader.consume(length);
+        return huffman.symbols[huffman.first_symbol[length] + ((k >> (16 - length)) - huffman.first_code[length])];
+    }
+
+    static constexpr u16 LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static constexpr u8 LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static constexpr u16 DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    static constexpr u8 DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+    static constexpr u8 CODE_LENGTH_ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+    struct PngFixedTables
+    {
+        PngHuffman literals;
+        PngHuffman distances;
+
+        PngFixedTables()
+        {
+            u8 lengths[288];
+            std::memset(lengths, 8, 144);
+            std::memset(lengths + 144, 9, 112);
+            std::memset(lengths + 256, 7, 24);
+            std::memset(lengths + 280, 8, 8);
+            _build_huffman(literals, lengths, 288);
+
+            std::memset(lengths, 5, 30);
+            _build_huffman(distances, lengths, 30);
+        }
+    };
+
+    static bool _read_dynamic_tables(PngBitReader& reader, PngHuffman& literals, PngHuffman& distances)
+    {
+        reader.refill();
+        u32 literal_count = reader.bits(5) + 257;
+        u32 distance_count = reader.bits(5) + 1;
+        u32 code_length_count = reader.bits(4) + 4;
+        if (literal_count > 286 || distance_count > 30) return false;
+
+        u8 code_lengths[19] = {};
+        for (u32 i = 0; i < code_length_count; i++)
+        {
+            reader.refill();
+            code_lengths[CODE_LENGTH_ORDER[i]] = (u8)reader.bits(3);
+        }
+
+        PngHuffman code_length_huffman;
+        if (!_build_huffman(code_length_huffman, code_lengths, 19)) return false;
+
+        u8 lengths[286 + 30];
+        u32 total = literal_count + distance_count;
+        for (u32 n = 0; n < total;)
+        {
+            reader.refill();
+            u32 symbol = _decode_symbol(reader, code_length_huffman);
+            if (symbol < 16)
+            {
+                lengths[n++] = (u8)symbol;
+                continue;
+            }
+
+            u8 value = 0;
+            u32 repeat;
+            switch(symbol)
+            {
+                case 16:
+                {
+                    if (n == 0) return false;
+                    value = lengths[n - 1];
+                    repeat = 3 + reader.bits(2);
+                } break;
+                case 17: repeat = 3 + reader.bits(3); break;
+                case 18: repeat = 11 + reader.bits(7); break;
+                default: return false;
+            }
+
+            if (repeat > total - n) return false;
+            std::memset(lengths + n, value, repeat);
+            n += repeat;
+        }
+
+        // without an end of block code the block could never finish
+        if (lengths[256] == 0) return false;
+
+        return _build_huffman(literals, lengths, literal_count) && _build_huffman(distances, lengths + literal_count, distance_count);
+    }
+
+    /// @brief Inflate a zlib stream into exactly `out_size` bytes. `out` must have 8 bytes of room past `out_size`,
+    /// which match copies are allowed to scribble over.
+    static bool _inflate(const u8* data, size_t size, u8* out, size_t out_size)
+    {
+        if (size < 2) return false;
+
+        u8 cmf = data[0], flg = data[1];
+        if ((cmf & 15) != 8 || ((cmf << 8) | flg) % 31 != 0 || (flg & 32)) return false;
+
+        static const PngFixedTables FIXED;
+        PngHuffman dynamic_literals, dynamic_distances;
+
+        PngBitReader reader{ data + 2, size - 2 };
+        size_t written = 0;
+
+        bool final = false;
+        while (!final)
+        {
+            reader.refill();
+            final = reader.bits(1);
+            u32 type = reader.bits(2);
+
+            if (type == 0)
+            { // stored: restart the reader at the next byte boundary and copy straight through
+                reader.consume(reader.bit_count & 7);
+                reader.pos -= reader.bit_count >> 3;
+                reader.buffer = 0;
+                reader.bit_count = 0;
+
+                if (reader.pos + 4 > reader.size) return false;
+                u32 length = reader.data[reader.pos] | (reader.data[reader.pos + 1] << 8);
+                u32 inverse = reader.data[reader.pos + 2] | (reader.data[reader.pos + 3] << 8);
+                reader.pos += 4;
+
+                if ((length ^ 0xffff) != inverse || length > reader.size - reader.pos || length > out_size - written) return false;
+                std::memcpy(out + written, reader.data + reader.pos, length);
+                reader.pos += length;
+                written += length;
+                continue;
+            }
+
+            const PngHuffman* literals = &FIXED.literals;
+            const PngHuffman* distances = &FIXED.distances;
+            if (type == 2)
+            {
+                if (!_read_dynamic_tables(reader, dynamic_literals, dynamic_distances)) return false;
+                literals = &dynamic_literals;
+                distances = &dynamic_distances;
+            }
+            else if (type != 1) return false;
+
+            while (true)
+            {
+                // one refill covers a length code and its extra bits (20) plus a distance and its extra bits (28)
+                reader.refill();
+                u32 symbol = _decode_symbol(reader, *literals);
+
+                if (symbol < 256)
+                {
+                    if (written == out_size) return false;
+                    out[written++] = (u8)symbol;
+                    continue;
+                }
+                if (symbol == 256) break;
+
+                symbol -= 257;
+                if (symbol >= 29) return false;
+                u32 length = LENGTH_BASE[symbol] + reader.bits(LENGTH_EXTRA[symbol]);
+
+                u32 distance_symbol = _decode_symbol(reader, *distances);
+                if (distance_symbol >= 30) return false;
+                u32 distance = DISTANCE_BASE[distance_symbol] + reader.bits(DISTANCE_EXTRA[distance_symbol]);
+
+                if (distance > written || length > out_size - written) return false;
+
+                u8* dst = out + written;
+                const u8* src = dst - distance;
+                written += length;
+
+                if (distance >= 8)
+                { // whole words; the source is always at least one word behind, so every word read is complete
+                    for (u32 i = 0; i < length; i += 8)
+                        std::memcpy(dst + i, src + i, 8);
+                }
+                else if (distance == 1) std::memset(dst, *src, length);
+                else for (u32 i = 0; i < length; i++) dst[i] = src[i];
+            }
+
+            if (reader.overrun()) return false;
+        }
+
+        return written == out_size;
+    }
+
+    // unfiltering; the previous row is already unfiltered, and all zeros above the first row
+
+    static u8 _paeth(u8 a, u8 b, u8 c)
+    {
+        i32 p = (i32)a + b - c;
+        i32 pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+        if (pa <= pb && pa <= pc) return a;
+        return pb <= pc ? b : c;
+    }
+
+#if defined(INX_PNG_SSE2)
+    // the pixel size is a template parameter so these copies compile to single moves
+    template<u32 BPP>
+    static __m128i _load_pixel(const u8* pixel)
+    {
+        u32 value = 0;
+        std::memcpy(&value, pixel, BPP);
+        return _mm_cvtsi32_si128((int)value);
+    }
+
+    template<u32 BPP>
+    static void _store_pixel(u8* pixel, __m128i value)
+    {
+        u32 bytes = (u32)_mm_cvtsi128_si32(value);
+        std::memcpy(pixel, &bytes, BPP);
+    }
+
+    /// @brief Sub, Average and Paeth for 3 and 4 byte pixels, a whole pixel per step
+    template<u32 BPP, u8 FILTER>
+    static void _unfilter_pixels(u8* row, const u8* prev, size_t row_bytes)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i one = _mm_set1_epi8(1);
+
+        __m128i a = zero, c = zero;
+        for (size_t i = 0; i + BPP <= row_bytes; i += BPP)
+        {
+            __m128i x = _load_pixel<BPP>(row + i);
+            __m128i b = _load_pixel<BPP>(prev + i);
+
+            switch(FILTER)
+            {
+                case 1: x = _mm_add_epi8(x, a); break;
+                case 3:
+                {
+                    // avg rounds up; the filter rounds down
+                    __m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+                    x = _mm_add_epi8(x, average);
+                } break;
+                case 4:
+                {
+                    __m128i a16 = _mm_unpacklo_epi8(a, zero);
+                    __m128i b16 = _mm_unpacklo_epi8(b, zero);
+                    __m128i c16 = _mm_unpacklo_epi8(c, zero);
+
+                    __m128i pa = _mm_sub_epi16(b16, c16);
+                    __m128i pb = _mm_sub_epi16(a16, c16);
+                    __m128i pc = _mm_add_epi16(pa, pb);
+                    pa = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+                    pb = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+                    pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+
+                    // ties go to a, then b
+                    __m128i not_b = _mm_cmpgt_epi16(pb, pc);
+                    __m128i predictor = _mm_or_si128(_mm_andnot_si128(not_b, b16), _mm_and_si128(not_b, c16));
+                    __m128i not_a = _mm_cmpgt_epi16(pa, _mm_min_epi16(pb, pc));
+                    predictor = _mm_or_si128(_mm_andnot_si128(not_a, a16), _mm_and_si128(not_a, predictor));
+
+                    x = _mm_add_epi8(x, _mm_packus_epi16(predictor, predictor));
+                } break;
+            }
+
+            _store_pixel<BPP>(row + i, x);
+            a = x;
+            c = b;
+        }
+    }
+
+    template<u32 BPP>
+    static void _unfilter_pixels(u8 filter, u8* row, const u8* prev, size_t row_bytes)
+    {
+        switch(filter)
+        {
+            case 1: _unfilter_pixels<BPP, 1>(row, prev, row_bytes); break;
+            case 3: _unfilter_pixels<BPP, 3>(row, prev, row_bytes); break;
+            case 4: _unfilter_pixels<BPP, 4>(row, prev, row_bytes); break;
+        }
+    }
+#endif
+
+    static bool _unfilter_row(u8 filter, u8* row, const u8* prev, size_t row_bytes, u32 bpp)
+    {
+        size_t i = 0;
+        switch(filter)
+        {
+            case 0: return true;
+
+            case 2:
+            {
+#if defined(INX_PNG_SSE2)
+                for (; i + 16 <= row_bytes; i += 16)
+                {
+                    __m128i x = _mm_loadu_si128((const __m128i*)(row + i));
+                    __m128i b = _mm_loadu_si128((const __m128i*)(prev + i));
+                    _mm_storeu_si128((__m128i*)(row + i), _mm_add_epi8(x, b));
+                }
+#endif
+                for (; i < row_bytes; i++)
+                    row[i] += prev[i];
+            } return true;
+
+            case 1:
+            case 3:
+            case 4:
+            {
+#if defined(INX_PNG_SSE2)
+                if (bpp == 3 || bpp == 4)
+                {
+                    if (bpp == 3) _unfilter_pixels<3>(filter, row, prev, row_bytes);
+                    else _unfilter_pixels<4>(filter, row, prev, row_bytes);
+                    return true;
+                }
+#endif
+                for (; i < bpp; i++)
+                {
+                    if (filter == 3) row[i] += prev[i] >> 1;
+                    else if (filter == 4) row[i] += prev[i];
+                }
+
+                for (; i < row_bytes; i++)
+                {
+                    switch(filter)
+                    {
+                        case 1: row[i] += row[i - bpp]; break;
+                        case 3: row[i] += (u8)(((u32)row[i - bpp] + prev[i]) >> 1); break;
+                        case 4: row[i] += _paeth(row[i - bpp], prev[i], prev[i - bpp]); break;
+                    }
+                }
+            } return true;
+        }
+
+        return false;
+    }
+
+    bool decode_png(const u8* data, size_t size, const PngInfo& info, u8* out)
+    {
+        std::vector<u8> compressed;
+        std::array<u32, 256> palette{};
+
+        _for_each_chunk(data, size, [&](const u8* type, const u8* chunk, u32 length)
+        {
+            if (std::memcmp(type, "IDAT", 4) == 0)
+            {
+                compressed.insert(compressed.end(), chunk, chunk + length);
+            }
+            else if (std::memcmp(type, "PLTE", 4) == 0)
+            {
+                for (u32 i = 0; i < length / 3 && i < 256; i++)
+                    palette[i] = chunk[i * 3] | (chunk[i * 3 + 1] << 8) | (chunk[i * 3 + 2] << 16) | 0xff000000u;
+            }
+            else if (std::memcmp(type, "tRNS", 4) == 0)
+            {
+                for (u32 i = 0; i < length && i < 256; i++)
+                    palette[i] = (palette[i] & 0x00ffffffu) | ((u32)chunk[i] << 24);
+            }
+
+            return true;
+        });
+
+        const u32 bpp = _png_bpp(info.colour_type);
+        const size_t row_bytes = (size_t)info.width * bpp;
+        const size_t stride = row_bytes + 1;
+
+        std::vector<u8> filtered(stride * info.height + 8);
+        if (!_inflate(compressed.data(), compressed.size(), filtered.data(), stride * info.height)) return false;
+
+        const std::vector<u8> zero_row(row_bytes, 0);
+        const size_t out_row = (size_t)info.width * info.channels;
+
+        for (u32 y = 0; y < info.height; y++)
+        {
+            u8* row = filtered.data() + y * stride + 1;
+            const u8* prev = y == 0 ? zero_row.data() : row - stride;
+            if (!_unfilter_row(row[-1], row, prev, row_bytes, bpp)) return false;
+
+            // PNG rows run top to bottom, GL's bottom to top
+            u8* dst = out + (size_t)(info.height - 1 - y) * out_row;
+            switch(info.colour_type)
+            {
+                case PNG_GREY:
+                case PNG_RGBA:          std::memcpy(dst, row, out_row); break;
+                case PNG_RGB:           image_kernels::rgb_to_rgba(row, dst, info.width); break;
+                case PNG_GREY_ALPHA:    image_kernels::grey_alpha_to_rgba(row, dst, info.width); break;
+                case PNG_PALETTE:
+                {
+                    for (u32 x = 0; x < info.width; x++)
+                        std::memcpy(dst + x * 4, &palette[row[x]], 4);
+                } break;
+            }
+        }
+
+        return true;
+    }
+} // namespace inx
@@ -0,0 +1,176 @@
+#include "../resources.h"
+#include "../core.h"
+
+#include <thread>
+
+namespace inx
+{
+    u32 next_resource_type()
+    {
+        static std::atomic<u32> next = 0;
+        return next++;
+    }
+
+    void ResourceManager::_submit(std::function<void()> job)
+    {
+        Jobs::submit(std::move(job));
+    }
+
+    void ResourceManager::_release(u32 type, u32 index)
+    {
+        auto& pool = _pools[type];
+        auto& slot = pool.slots[index];
+
+        pool.ids.erase(slot.id.hash);
+        pool.free.push_back(index);
+
+        slot.resource.reset();
+        slot.name.clear();
+        slot.generation++;
+    }
+
+    void ResourceManager::_release_failed(const PendingLoad& load)
+    {
+        // left reserved, the slot would keep every load depending on it waiting forever; freed, they fail as missing
+        // dependencies. Unless it was unloaded or replaced already, in which case it isn't this load's to free.
+        const auto& self = load.slot;
+        if (_pools[self.type].slots[self.index].generation == self.generation) _release(self.type, self.index);
+    }
+
+    void ResourceManager::process_loads()
+    {
+        // finalising one load can make a later one ready, so a whole chain of dependencies goes in one call
+        for (size_t i = 0; i < _pending.size();)
+        {
+            auto load = _pending[i];
+            if (!load->prepared.load(std::memory_order_acquire))
+            {
+                i++;
+                continue;
+            }
+
+            bool waiting = false;
+            for (const auto& dependency : load->dependencies)
+            {
+                const Slot* slot = dependency.type < _pools.size() && dependency.index < _pools[dependency.type].slots.size()
+                    ? &_pools[dependency.type].slots[dependency.index] : nullptr;
+
+                if (!slot || slot->generation != dependency.generation)
+                { // unloaded or replaced, so it will never arrive; this load fails, and anything waiting on it in turn
+                    _pending.erase(_pending.begin() + i);
+                    _release_failed(*load);
+                    std::cerr << "Resource [" << load->name << "] depends on a resource that is no longer loaded\n";
+                    throw std::runtime_error("Missing dependency of resource: " + load->name);
+                }
+
+                waiting |= !slot->resource;
+            }
+
+            if (waiting)
+            {
+                i++;
+                continue;
+            }
+
+            // off the list before finalising, which is free to start more loads
+            _pending.erase(_pending.begin() + i);
+
+            if (load->error)
+            {
+                _release_failed(*load);
+                std::cerr << "Resource [" << load->name << "] failed to load\n";
+                std::rethrow_exception(load->error);
+            }
+
+            load->finalise(*this);
+            i = 0;
+        }
+    }
+
+    void ResourceManager::finish_loads()
+    {
+        process_loads();
+        while (!_pending.empty())
+        {
+            std::this_thread::yield();
+            process_loads();
+        }
+    }
+
+    u32 ResourceManager::IdTable::find(u64 hash) const
+    {
+        if (_entries.empty()) return NONE;
+
+        const size_t mask = _entries.size() - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask)
+        {
+            const auto& entry = _entries[i];
+            if (entry.index == NONE) return NONE;
+            if (entry.hash == hash) return entry.index;
+        }
+    }
+
+    void ResourceManager::IdTable::insert(u64 hash, u32 index)
+    {
+        // kept at most 3/4 full so probe runs stay short and there is always an empty entry to stop on
+        if ((_count + 1) * 4 > _entries.size() * 3) _grow();
+
+        const size_t mask = _entries.size() - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask)
+        {
+            auto& entry = _entries[i];
+            if (entry.index == NONE)
+            {
+                entry = { hash, index };
+                _count++;
+                return;
+            }
+
+            if (entry.hash == hash)
+            {
+                entry.index = index;
+                return;
+            }
+        }
+    }
+
+    void ResourceManager::IdTable::erase(u64 hash)
+    {
+        if (_entries.empty()) return;
+
+        const size_t mask = _entries.size() - 1;
+        size_t hole = hash & mask;
+        while (_entries[hole].hash != hash || _entries[hole].index == NONE)
+        {
+            if (_entries[hole].index == NONE) return;
+            hole = (hole + 1) & mask;
+        }
+
+        // backward shift instead of tombstones: pull later entries of the run into the hole unless that would move
+        // them in front of their home position
+        for (size_t i = (hole + 1) & mask; _entries[i].index != NONE; i = (i + 1) & mask)
+        {
+            size_t home = _entries[i].hash & mask;
+            if (((i - home) & mask) >= ((i - hole) & mask))
+            {
+                _entries[hole] = _entries[i];
+                hole = i;
+            }
+        }
+
+        _entries[hole] = {};
+        _count--;
+    }
+
+    void ResourceManager::IdTable::_grow()
+    {
+        std::vector<Entry> old = std::move(_entries);
+        _entries.assign(old.empty() ? 16 : old.size() * 2, Entry{});
+        _count = 0;
+
+        for (const auto& entry : old)
+        {
+            if (entry.index != NONE) insert(entry.hash, entry.index);
+        }
+    }
+} // namespace inx
@@ -0,0 +1,93 @@
+#ifndef __INX_RESOURCES_INTERNAL_H__
+#define __INX_RESOURCES_INTERNAL_H__
+
+#include <filesystem>
+#include <vector>
+
+#include "../resources.h"
+#include "../types.h"
+
+namespace inx
+{
+    struct MappedFile;
+
+    /// @brief One stored mip level of an Image, as a byte range of its pixels
+    struct ImageLevel
+    {
+        size_t offset;
+        size_t size;
+        u32 width;
+        u32 height;
+    };
+
+    /// @brief Image in CPU memory, rows stored bottom to top as GL expects. Freshly decoded files are 8 bits per
+    /// channel with a single level; images from the decoded image cache have their whole mip chain in `levels`, and
+    /// KTX2 files keep their (possibly compressed) format and stored mip chain.
+    struct Image
+    {
+        u32 width = 0;
+        u32 height = 0;
+        u32 channels = 0;
+        ImageFormat format = ImageFormat::None;
+        std::vector<u8> pixels;
+
+        /// @brief empty for a single uncompressed level
+        std::vector<ImageLevel> levels;
+
+        /// @brief set instead of `pixels` when the image is read straight out of a mapped cache file
+        Ref<MappedFile> mapping;
+        const u8* mapped = nullptr;
+        size_t mapped_size = 0;
+
+        /// @brief the pixel data, wherever it lives; read through these rather than `pixels`
+        const u8* data() const { return mapping ? mapped : pixels.data(); }
+        size_t size() const { return mapping ? mapped_size : pixels.size(); }
+
+        bool valid() const { return size() > 0; }
+    };
+
+    /// @brief Decode an image file. Safe to call from any thread; returns an invalid image on failure.
+    ///
+    /// PNGs, JPEGs etc. go through the decoded image cache: the flipped pixels and their mip chain are stored under
+    /// CACHE_PATH keyed by a hash of the file's contents, and later loads of an unchanged file map that instead of
+    /// decoding again.
+    Image decode_image(const std::filesystem::path& filepath);
+
+    /// @brief Fill in every mip level of a single level uncompressed image with a 2x2 box filter. Images that already
+    /// have levels (or are compressed) are left as they are.
+    void generate_mip_chain(Image& image);
+
+    struct PngInfo
+    {
+        u32 width = 0;
+        u32 height = 0;
+        u8 colour_type = 0;
+
+        /// @brief channels decode_png() writes: 1 for greyscale, 4 (RGBA) for everything else
+        u32 channels = 0;
+    };
+
+    /// @brief Read a PNG's header. False if it isn't a PNG or uses something the fast decoder leaves to stb_image
+    /// (16 bit or sub byte channels, interlacing, colour keyed transparency).
+    bool png_info(const u8* data, size_t size, PngInfo& info);
+
+    /// @brief Decode a PNG accepted by png_info() into `out`, which holds width * height * channels bytes (a mapped
+    /// pixel buffer works as well as anything else). Rows are written bottom to top. False if the file is corrupt.
+    bool decode_png(const u8* data, size_t size, const PngInfo& info, u8* out);
+
+    /// @brief Look an image up in the decoded image cache by the hash of its source file; invalid on a miss
+    Image load_cached_image(u64 content_hash);
+
+    /// @brief Store an image (normally with its mip chain) in the decoded image cache. The cache is only an
+    /// optimisation, so failing to write it is not an error.
+    void save_cached_image(u64 content_hash, const Image& image);
+
+    /// @brief Decode several files at once on the job pool; blocks until all are done
+    std::vector<Image> decode_images(const std::vector<std::filesystem::path>& filepaths);
+
+    /// @brief Read a KTX2 file without supercompression. Safe to call from any thread; returns an invalid image
+    /// on failure.
+    Image load_ktx2(const std::filesystem::path& filepath);
+} // namespace inx
+
+#endif // __INX_RESOURCES_INTERNAL_H__
\ No newline at end of file
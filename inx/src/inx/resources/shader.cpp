@@ -4,10 +4,37 @@
 
 namespace inx
 {
-    Scope<Shader> Shader::load(const std::filesystem::path& vertex_filepath, const std::filesystem::path& fragment_filepath)
+    Scope<Shader> Shader::load(const std::filesystem::path& vertex_filepath, const std::filesystem::path& fragment_filepath, const ShaderDefines& defines, ShaderLinkage linkage)
     {
         // NOTE(selina): In the future this will change what it returns based on current rendering API - 15/08
-        auto result = create_scope<OpenGLShader>(vertex_filepath, fragment_filepath);
+        if (linkage == ShaderLinkage::Separable)
+            return create_scope<OpenGLPipelineShader>(vertex_filepath, fragment_filepath, defines);
+
+        auto result = create_scope<OpenGLShader>(vertex_filepath, fragment_filepath, defines);
         return result;
     }
+
+    ShaderSources Shader::prepare(const std::filesystem::path& vertex_filepath, const std::filesystem::path& fragment_filepath, const ShaderDefines& defines, ShaderLinkage linkage)
+    {
+        return { preprocess_shader(vertex_filepath, defines), preprocess_shader(fragment_filepath, defines), linkage };
+    }
+
+    Scope<Shader> Shader::finalise(ResourceManager& manager, ShaderSources&& sources)
+    {
+        if (sources.linkage == ShaderLinkage::Separable)
+            return create_scope<OpenGLPipelineShader>(std::move(sources.vertex), std::move(sources.fragment));
+
+        auto result = create_scope<OpenGLShader>(std::move(sources.vertex), std::move(sources.fragment));
+        return result;
+    }
+
+    UniformStats Shader::uniform_stats()
+    {
+        return OpenGLProgram::uniform_stats();
+    }
+
+    void Shader::reset_uniform_stats()
+    {
+        OpenGLProgram::reset_uniform_stats();
+    }
 } // namespace inx
\ No newline at end of file
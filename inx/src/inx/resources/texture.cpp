@@ -1,4 +1,5 @@
 #include "../resources.h"
+#include "resources_internal.h"
 
 #include "../platform/opengl.h"
 
@@ -17,4 +18,47 @@ namespace inx
         auto result = create_scope<OpenGLTexture>(spec);
         return result;
     }
+
+    TextureSource Texture::prepare(const std::filesystem::path& texture_filepath)
+    {
+        auto image = create_ref<Image>(decode_image(texture_filepath));
+
+        // only KTX2 files can arrive without one; streaming needs the CPU mip chain and the texture won't build it
+        generate_mip_chain(*image);
+
+        return { texture_filepath, image };
+    }
+
+    Scope<Texture> Texture::finalise(ResourceManager& manager, TextureSource&& source)
+    {
+        auto result = create_scope<OpenGLTexture>(source.filepath, std::move(source.image));
+        return result;
+    }
+
+    Scope<Texture2DArray> Texture2DArray::load(const TextureArraySpec& spec)
+    {
+        auto result = create_scope<OpenGLTexture2DArray>(spec);
+        return result;
+    }
+
+    Scope<VirtualTexture> VirtualTexture::load(const std::filesystem::path& image_filepath, const VirtualTextureSpec& spec)
+    {
+        auto result = create_scope<OpenGLVirtualTexture>(image_filepath, spec);
+        return result;
+    }
+
+    void Texture::process_uploads(size_t byte_budget)
+    {
+        OpenGLTexture::process_uploads(byte_budget);
+    }
+
+    void Texture::streaming_budget(size_t bytes)
+    {
+        OpenGLTexture::streaming_budget(bytes);
+    }
+
+    TextureStreamingStats Texture::streaming_stats()
+    {
+        return OpenGLTexture::streaming_stats();
+    }
 } // namespace inx
\ No newline at end of file
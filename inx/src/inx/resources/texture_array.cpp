@@ -0,0 +1,90 @@
+#include "../resources.h"
+#include "resources_internal.h"
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+namespace inx
+{
+    Scope<TextureArraySet> TextureArraySet::load()
+    {
+        return create_scope<TextureArraySet>();
+    }
+
+    void TextureArraySet::add(const std::string& resource_id, const std::filesystem::path& image_filepath)
+    {
+        _queued.emplace_back(resource_id, image_filepath);
+    }
+
+    void TextureArraySet::build(ResourceManager& manager)
+    {
+        if (_queued.empty()) return;
+
+        std::vector<std::filesystem::path> filepaths;
+        for (const auto& [resource_id, filepath] : _queued)
+            filepaths.push_back(filepath);
+
+        auto images = decode_images(filepaths);
+
+        // every layer of an array shares its size, format and mip chain
+        using GroupKey = std::tuple<u32, u32, ImageFormat, size_t>;
+        std::map<GroupKey, std::vector<size_t>> groups;
+
+        for (size_t i = 0; i < images.size(); i++)
+        {
+            const auto& image = images[i];
+            if (!image.valid() || image.format == ImageFormat::None)
+            {
+                std::cerr << "Could not load array image: " << filepaths[i].string() << "\n";
+                throw std::runtime_error(std::string("Could not load array image: ") + filepaths[i].string());
+            }
+
+            groups[{ image.width, image.height, image.format, image.levels.size() }].push_back(i);
+        }
+
+        for (const auto& [key, members] : groups)
+        {
+            const auto& [width, height, format, level_count] = key;
+
+            for (size_t first = 0; first < members.size(); first += MAX_LAYERS)
+            {
+                size_t count = std::min<size_t>(MAX_LAYERS, members.size() - first);
+
+                // decoded images get a generated chain; stored chains (KTX2) are used as they are
+                TextureArraySpec spec;
+                spec.width = width;
+                spec.height = height;
+                spec.layers = (u32)count;
+                spec.format = format;
+                spec.levels = level_count == 0 ? 0 : (u32)level_count;
+
+                auto array = Texture2DArray::load(spec);
+
+                for (u32 layer = 0; layer < count; layer++)
+                {
+                    size_t index = members[first + layer];
+                    const auto& image = images[index];
+
+                    if (image.levels.empty())
+                        array->data(layer, image.data(), (u32)image.size());
+                    else for (u32 level = 0; level < image.levels.size(); level++)
+                        array->data(layer, image.data() + image.levels[level].offset, (u32)image.levels[level].size, level);
+
+                    auto region = create_scope<ArrayLayer>();
+                    region->texture = array.get();
+                    region->layer = layer;
+                    region->width = width;
+                    region->height = height;
+                    manager.add_resource<ArrayLayer>(_queued[index].first, std::move(region));
+                }
+
+                if (level_count == 0) array->generate_mipmaps();
+
+                _arrays.push_back(std::move(array));
+            }
+        }
+
+        _queued.clear();
+    }
+} // namespace inx
@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <memory>
+#include <string_view>
 
 typedef int8_t      i8;
 typedef int16_t     i16;
@@ -32,6 +33,31 @@ namespace inx
     {
         return std::make_shared<T>(std::forward<Args>(args)...);
     }
+
+    /// @brief 32-bit FNV-1a hash. constexpr so that string literals can be hashed at compile time.
+    constexpr u32 hash_fnv1a(std::string_view str)
+    {
+        u32 hash = 2166136261u;
+        for (char c : str)
+        {
+            hash ^= (u8)c;
+            hash *= 16777619u;
+        }
+
+        return hash;
+    }
+
+    /// @brief 64-bit FNV-1a hash. Pass a previous result as the seed to hash several strings together.
+    constexpr u64 hash_fnv1a64(std::string_view str, u64 hash = 14695981039346656037ull)
+    {
+        for (char c : str)
+        {
+            hash ^= (u8)c;
+            hash *= 1099511628211ull;
+        }
+
+        return hash;
+    }
 } // namespace inx
 
 #endif // __INX_TYPES_H__
\ No newline at end of file
@@ -0,0 +1,118 @@
+using namespace inx;
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "inx/renderer.h"
+#include "inx/resources.h"
+
+// one sprite from an atlas page, one from a texture array and a virtual textured quad, next to the quad grid
+
+struct TexturesDemoData
+{
+    Handle<TextureAtlas> atlas;
+    Handle<TextureArraySet> array_set;
+
+    Handle<AtlasRegion> atlas_sprite;
+    Handle<ArrayLayer> array_sprite;
+
+    Handle<VirtualTexture> virtual_texture;
+    Handle<Shader> virtual_shader;
+    Handle<Shader> virtual_feedback_shader;
+    VAO virtual_quad_vao;
+
+    // [0] the visible pass, [1] the feedback pass
+    UniformId vp_matrix[2], model[2];
+};
+
+static TexturesDemoData s_TexturesDemo;
+
+void init_textures_demo(ResourceManager& manager)
+{
+    s_TexturesDemo.atlas = manager.load_resource<TextureAtlas>("demo_atlas", TextureAtlasSpec{ .page_size = 1024 });
+    auto& atlas = manager.get_resource(s_TexturesDemo.atlas);
+    atlas.add("demo_atlas_container", PATH("container.png"));
+    atlas.add("demo_atlas_container_spec", PATH("container_spec.png"));
+    atlas.build(manager);
+    s_TexturesDemo.atlas_sprite = manager.find_resource<AtlasRegion>("demo_atlas_container"_rid);
+
+    // both images are the same size and format, so they end up as two layers of one array
+    s_TexturesDemo.array_set = manager.load_resource<TextureArraySet>("demo_arrays");
+    auto& array_set = manager.get_resource(s_TexturesDemo.array_set);
+    array_set.add("demo_layer_container", PATH("container.png"));
+    array_set.add("demo_layer_container_spec", PATH("container_spec.png"));
+    array_set.build(manager);
+    s_TexturesDemo.array_sprite = manager.find_resource<ArrayLayer>("demo_layer_container_spec"_rid);
+
+    // 512x512 at the default 128 pixel pages: 4x4 pages on the base level, 3 mips
+    auto virtual_pages_path = PATH("virtual_pages.png");
+    s_TexturesDemo.virtual_texture = manager.load_resource<VirtualTexture>("demo_virtual", virtual_pages_path, VirtualTextureSpec{});
+
+    auto virtual_vs = PATH("virtual_quad.vs");
+    auto virtual_fs = PATH("virtual_quad.fs");
+    s_TexturesDemo.virtual_shader = manager.load_resource<Shader>("virtual_quad", virtual_vs, virtual_fs);
+    s_TexturesDemo.virtual_feedback_shader = manager.load_resource<Shader>("virtual_quad_feedback", virtual_vs, virtual_fs, ShaderDefines{ { "VT_FEEDBACK", "1" } });
+
+    const Shader* shaders[2] = { &manager.get_resource(s_TexturesDemo.virtual_shader), &manager.get_resource(s_TexturesDemo.virtual_feedback_shader) };
+    for (u32 i = 0; i < 2; i++)
+    {
+        s_TexturesDemo.vp_matrix[i] = shaders[i]->uniform("u_vp_matrix");
+        s_TexturesDemo.model[i] = shaders[i]->uniform("u_model");
+    }
+
+    float vertices[] = {
+        // positions          // texture coords
+        -0.5f, -0.5f,  0.0f,  0.0f,  0.0f,
+         0.5f, -0.5f,  0.0f,  1.0f,  0.0f,
+         0.5f,  0.5f,  0.0f,  1.0f,  1.0f,
+         0.5f,  0.5f,  0.0f,  1.0f,  1.0f,
+        -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,
+        -0.5f, -0.5f,  0.0f,  0.0f,  0.0f,
+    };
+
+    auto quad_vbo = VertexBuffer::create(vertices, sizeof(vertices));
+    quad_vbo->layout({
+        { "position",  BufferElementDataType::Float3 },
+        { "tex_coord", BufferElementDataType::Float2 },
+    });
+
+    s_TexturesDemo.virtual_quad_vao = VertexArray::create();
+    s_TexturesDemo.virtual_quad_vao->add_vertex_buffer(quad_vbo);
+}
+
+/// @brief call between render2d::begin_batch() and end_batch(); neither sprite breaks the batch
+void draw_textures_demo_sprites(ResourceManager& manager)
+{
+    render2d::draw_quad(glm::vec3(-1.5f, 11.5f, 0.f), glm::vec2(2.f), manager.get_resource(s_TexturesDemo.atlas_sprite));
+    render2d::draw_quad(glm::vec3( 1.5f, 11.5f, 0.f), glm::vec2(2.f), manager.get_resource(s_TexturesDemo.array_sprite));
+}
+
+/// @brief Feedback pass, the visible pass and the page update for the virtual textured quad
+void draw_textures_demo_virtual(ResourceManager& manager, const glm::mat4& vp_matrix, int w, int h)
+{
+    auto& vt = manager.get_resource(s_TexturesDemo.virtual_texture);
+
+    glm::mat4 model = glm::translate(glm::mat4(1.f), glm::vec3(13.f, 0.f, 0.f));
+    model = glm::scale(model, glm::vec3(6.f));
+
+    s_TexturesDemo.virtual_quad_vao->bind();
+
+    auto& feedback_shader = manager.get_resource(s_TexturesDemo.virtual_feedback_shader);
+    vt.begin_feedback(w, h);
+    feedback_shader.bind();
+    vt.bind(feedback_shader, GL_TEXTURE0, GL_TEXTURE1);
+    feedback_shader.set_mat4(s_TexturesDemo.vp_matrix[1], vp_matrix);
+    feedback_shader.set_mat4(s_TexturesDemo.model[1], model);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    vt.end_feedback();
+
+    auto& shader = manager.get_resource(s_TexturesDemo.virtual_shader);
+    shader.bind();
+    vt.bind(shader, GL_TEXTURE0, GL_TEXTURE1);
+    shader.set_mat4(s_TexturesDemo.vp_matrix[0], vp_matrix);
+    shader.set_mat4(s_TexturesDemo.model[0], model);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+
+    vt.update();
+}
@@ -0,0 +1,8 @@
+// mirrors inx::std140::Camera in renderer.h
+
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+    vec3 position;
+} u_camera;
@@ -0,0 +1,52 @@
+// light structs mirror inx::std140 in renderer.h; the member order matters for std140 packing
+
+struct DirectionalLight 
+{
+    vec3 direction;
+	
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct PointLight 
+{
+    vec3 position;
+    float constant;
+
+    vec3 ambient;
+    float linear;
+
+    vec3 diffuse;
+    float quadratic;
+
+    vec3 specular;
+};
+
+struct Spotlight 
+{
+    vec3 position;
+    float cutoff;
+
+    vec3 direction;
+    float outer_cutoff;
+  
+    vec3 ambient;
+    float constant;
+
+    vec3 diffuse;
+    float linear;
+
+    vec3 specular;       
+    float quadratic;
+};
+
+// the block always has room for every light so its layout never changes between variants
+#define MAX_POINT_LIGHTS 4
+
+layout (std140) uniform Lights
+{
+    DirectionalLight directional;
+    PointLight point_lights[MAX_POINT_LIGHTS];
+    Spotlight spotlight;
+} u_lights;
@@ -9,45 +9,22 @@ struct Material
     float shininess;
 }; 
 
-struct DirectionalLight 
-{
-    vec3 direction;
-	
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
-
-struct PointLight 
-{
-    vec3 position;
-    
-    float constant;
-    float linear;
-    float quadratic;
-	
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
-
-struct Spotlight 
-{
-    vec3 position;
-    vec3 direction;
-    float cutoff;
-    float outer_cutoff;
-  
-    float constant;
-    float linear;
-    float quadratic;
-  
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;       
-};
+// feature defines; Shader::load injects these per variant, the values here are only fallbacks
 
+#ifndef NR_POINT_LIGHTS
 #define NR_POINT_LIGHTS 4
+#endif
+
+#ifndef USE_DIRECTIONAL_LIGHT
+#define USE_DIRECTIONAL_LIGHT 1
+#endif
+
+#ifndef USE_SPOTLIGHT
+#define USE_SPOTLIGHT 1
+#endif
+
+#include "camera.glsl"
+#include "lights.glsl"
 
 // in variables
 
@@ -57,11 +34,7 @@ in vec2 v_texcoord;
 
 // uniforms
 
-uniform vec3                u_view_position;
-uniform DirectionalLight    u_directional_light;
-uniform PointLight          u_point_lights[NR_POINT_LIGHTS];
-uniform Spotlight           u_spotlight;
-uniform Material            u_material;
+uniform Material u_material;
 
 // function prototypes
 
@@ -73,17 +46,25 @@ void main()
 {    
     // properties
     vec3 norm           = normalize(v_normal);
-    vec3 view_direction = normalize(u_view_position - v_frag_position);
+    vec3 view_direction = normalize(u_camera.position - v_frag_position);
     
+    vec3 result = vec3(0.0);
+
     // phase 1: directional lighting
-    vec3 result = calculate_directional_light(u_directional_light, norm, view_direction);
+#if USE_DIRECTIONAL_LIGHT
+    result += calculate_directional_light(u_lights.directional, norm, view_direction);
+#endif
     
     // phase 2: point lights
+#if NR_POINT_LIGHTS > 0
     for(int i = 0; i < NR_POINT_LIGHTS; i++)
-        result += calculate_point_light(u_point_lights[i], norm, v_frag_position, view_direction);    
+        result += calculate_point_light(u_lights.point_lights[i], norm, v_frag_position, view_direction);    
+#endif
     
     // phase 3: spotlight
-    result += calculate_spotlight(u_spotlight, norm, v_frag_position, view_direction);    
+#if USE_SPOTLIGHT
+    result += calculate_spotlight(u_lights.spotlight, norm, v_frag_position, view_direction);    
+#endif
     
     o_colour = vec4(result, 1.0);
 }
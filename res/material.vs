@@ -7,16 +7,15 @@ out vec3 v_frag_position;
 out vec3 v_normal;
 out vec2 v_texcoord;
 
-uniform mat4 u_model;
-uniform mat4 u_view;
-uniform mat4 u_projection;
+#include "camera.glsl"
+#include "object.glsl"
 
 void main()
 {
     // out variables
-    v_frag_position = vec3(u_model * vec4(a_position, 1.0));
-    v_normal        = mat3(transpose(inverse(u_model))) * a_normal;
+    v_frag_position = vec3(u_object.model * vec4(a_position, 1.0));
+    v_normal        = mat3(transpose(inverse(u_object.model))) * a_normal;
     v_texcoord      = a_texcoord;
     
-    gl_Position = u_projection * u_view * vec4(v_frag_position, 1.0);
+    gl_Position = u_camera.projection * u_camera.view * vec4(v_frag_position, 1.0);
 }
\ No newline at end of file
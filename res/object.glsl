@@ -0,0 +1,6 @@
+// mirrors inx::std140::Object in renderer.h
+
+layout (std140) uniform Object
+{
+    mat4 model;
+} u_object;
@@ -5,11 +5,39 @@ layout (location = 0) out vec4 o_colour;
 in vec4 v_colour;
 in vec2 v_texcoord;
 in float v_texindex;
+in float v_texlayer;
 
-uniform sampler2D u_textures[32];
+// injected from render2d::texture_slot_count(); 15 leaves room for u_layers within the 16 units GL 4.1 guarantees
+#ifndef MAX_TEXTURE_SLOTS
+#define MAX_TEXTURE_SLOTS 15
+#endif
+
+uniform sampler2D u_textures[MAX_TEXTURE_SLOTS];
+uniform sampler2DArray u_layers;
+
+// glsl 330 only allows constant indices into sampler arrays; cases past the slot count are never reached, they only
+// need an index that compiles
+#define SAMPLE(n) case n: texel = texture(u_textures[n < MAX_TEXTURE_SLOTS ? n : 0], v_texcoord); break;
 
 void main()
 {
-    int i = int(v_texindex);
-    o_colour = v_colour;
+    vec4 texel = vec4(1.0);
+
+    if (v_texlayer >= 0.0)
+    {
+        texel = texture(u_layers, vec3(v_texcoord, v_texlayer));
+    }
+    else
+    {
+        int i = int(v_texindex + 0.5);
+        switch (i)
+        {
+            SAMPLE(0)  SAMPLE(1)  SAMPLE(2)  SAMPLE(3)  SAMPLE(4)  SAMPLE(5)  SAMPLE(6)  SAMPLE(7)
+            SAMPLE(8)  SAMPLE(9)  SAMPLE(10) SAMPLE(11) SAMPLE(12) SAMPLE(13) SAMPLE(14) SAMPLE(15)
+            SAMPLE(16) SAMPLE(17) SAMPLE(18) SAMPLE(19) SAMPLE(20) SAMPLE(21) SAMPLE(22) SAMPLE(23)
+            SAMPLE(24) SAMPLE(25) SAMPLE(26) SAMPLE(27) SAMPLE(28) SAMPLE(29) SAMPLE(30)
+        }
+    }
+
+    o_colour = v_colour * texel;
 }
\ No newline at end of file
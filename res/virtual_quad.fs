@@ -0,0 +1,17 @@
+#version 330 core
+
+layout (location = 0) out vec4 o_colour;
+
+in vec2 v_texcoord;
+
+#include "virtual_texture.glsl"
+
+// VT_FEEDBACK compiles the variant drawn between VirtualTexture::begin_feedback and end_feedback
+void main()
+{
+#ifdef VT_FEEDBACK
+    o_colour = vt_feedback(v_texcoord);
+#else
+    o_colour = vt_sample(v_texcoord);
+#endif
+}
@@ -0,0 +1,16 @@
+#version 330 core
+
+layout (location = 0) in vec3 a_position;
+layout (location = 1) in vec2 a_texcoord;
+
+uniform mat4 u_model;
+uniform mat4 u_vp_matrix;
+
+out vec2 v_texcoord;
+
+void main()
+{
+    v_texcoord = a_texcoord;
+
+    gl_Position = u_vp_matrix * u_model * vec4(a_position, 1.0);
+}
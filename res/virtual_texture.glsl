@@ -0,0 +1,50 @@
+// sampling side of inx::VirtualTexture; VirtualTexture::bind sets every uniform here
+
+uniform sampler2D u_vt_cache;
+uniform sampler2D u_vt_indirection;
+
+// x: virtual size in pixels, y: page size in pixels, z: page border in pixels
+uniform vec3 u_vt_page;
+
+// x: cache size in pixels, y: coarsest mip, z: lod bias (non zero in the feedback pass)
+uniform vec3 u_vt_cache_info;
+
+float vt_mip(vec2 uv)
+{
+    vec2 px = uv * u_vt_page.x;
+    vec2 dx = dFdx(px);
+    vec2 dy = dFdy(px);
+    float lod = 0.5 * log2(max(dot(dx, dx), dot(dy, dy)));
+
+    return clamp(floor(lod + u_vt_cache_info.z), 0.0, u_vt_cache_info.y);
+}
+
+// pages are sampled from a single mip, bilinear within it; there is no blending between mips
+vec4 vt_sample(vec2 uv)
+{
+    uv = clamp(uv, 0.0, 1.0);
+
+    // x, y: cache page, z: mip of the page actually resident for this spot
+    vec4 entry = floor(textureLod(u_vt_indirection, uv, vt_mip(uv)) * 255.0 + 0.5);
+
+    float pages = u_vt_page.x / (u_vt_page.y * exp2(entry.z));
+    vec2 position = uv * pages;
+    vec2 in_page = position - min(floor(position), pages - 1.0);
+
+    float tile = u_vt_page.y + 2.0 * u_vt_page.z;
+    vec2 texel = entry.xy * tile + u_vt_page.z + in_page * u_vt_page.y;
+
+    return textureLod(u_vt_cache, texel / u_vt_cache_info.x, 0.0);
+}
+
+// output of the feedback pass: the page this fragment wants, read back by VirtualTexture::update
+vec4 vt_feedback(vec2 uv)
+{
+    uv = clamp(uv, 0.0, 1.0);
+
+    float mip = vt_mip(uv);
+    float pages = u_vt_page.x / (u_vt_page.y * exp2(mip));
+    vec2 page = min(floor(uv * pages), pages - 1.0);
+
+    return vec4(page / 255.0, mip / 255.0, 1.0);
+}
@@ -0,0 +1,166 @@
+// Packs every file under a directory into one asset pack (see inx/core/pack_format.h) for AssetPack::mount:
+//
+//     packer <directory> <output.pack>
+//
+// Files are named by their path relative to the directory, so mount the pack with that directory as its root.
+
+#include "inx/core/pack_format.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace inx;
+
+struct PackFile
+{
+    std::string name;
+    std::filesystem::path path;
+    PackEntry entry{};
+};
+
+static void _write_padding(std::ofstream& out, u64 offset)
+{
+    static const char zeros[PACK_ALIGNMENT] = {};
+    out.write(zeros, (std::streamsize)(pack_align(offset) - offset));
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        std::cerr << "usage: packer <directory> <output.pack>\n";
+        return 1;
+    }
+
+    const std::filesystem::path root = argv[1];
+    const std::filesystem::path output = argv[2];
+
+    if (!std::filesystem::is_directory(root))
+    {
+        std::cerr << "Not a directory: " << root.string() << "\n";
+        return 1;
+    }
+
+    std::vector<PackFile> files;
+    for (const auto& item : std::filesystem::recursive_directory_iterator(root))
+    {
+        if (!item.is_regular_file()) continue;
+
+        // a pack written inside the directory it packs must not end up in the next one
+        std::error_code error;
+        if (std::filesystem::equivalent(item.path(), output, error)) continue;
+
+        PackFile file;
+        file.path = item.path();
+        file.name = item.path().lexically_relative(root).generic_string();
+        file.entry.name_hash = hash_fnv1a64(file.name);
+        file.entry.size = item.file_size();
+        files.push_back(std::move(file));
+    }
+
+    // two names sharing a hash would make one of them unreachable
+    std::sort(files.begin(), files.end(), [](const PackFile& a, const PackFile& b) { return a.entry.name_hash < b.entry.name_hash; });
+    for (size_t i = 1; i < files.size(); i++)
+    {
+        if (files[i].entry.name_hash == files[i - 1].entry.name_hash)
+        {
+            std::cerr << "Name hash collision: " << files[i - 1].name << " and " << files[i].name << "\n";
+            return 1;
+        }
+    }
+
+    // by name, so the same directory always produces the same pack
+    std::sort(files.begin(), files.end(), [](const PackFile& a, const PackFile& b) { return a.name < b.name; });
+
+    PackHeader header{};
+    std::memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+    header.version = PACK_VERSION;
+    header.entry_count = (u32)files.size();
+    header.alignment = PACK_ALIGNMENT;
+    header.toc_offset = pack_align(sizeof(PackHeader));
+    header.names_offset = header.toc_offset + files.size() * sizeof(PackEntry);
+
+    u64 offset = header.names_offset;
+    for (auto& file : files)
+    {
+        file.entry.name_offset = (u32)offset;
+        file.entry.name_size = (u32)file.name.size();
+        offset += file.name.size();
+    }
+    const u64 names_end = offset;
+
+    for (auto& file : files)
+    {
+        offset = pack_align(offset);
+        file.entry.offset = offset;
+        offset += file.entry.size;
+    }
+
+    // written next to the output and renamed over it at the end, so a failed run never leaves half a pack behind
+    auto temp_path = output;
+    temp_path += ".tmp";
+
+    std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        std::cerr << "Could not write " << temp_path.string() << "\n";
+        return 1;
+    }
+
+    // the table of contents needs every checksum, so it's written last; reserve its space for now
+    out.write((const char*)&header, sizeof(header));
+    _write_padding(out, sizeof(header));
+    std::vector<char> toc_space(files.size() * sizeof(PackEntry));
+    out.write(toc_space.data(), (std::streamsize)toc_space.size());
+
+    for (const auto& file : files)
+        out.write(file.name.data(), (std::streamsize)file.name.size());
+
+    offset = names_end;
+
+    std::vector<char> contents;
+    for (auto& file : files)
+    {
+        _write_padding(out, offset);
+        offset = pack_align(offset);
+
+        std::ifstream in(file.path, std::ios::binary);
+        contents.resize(file.entry.size);
+        if (!in.read(contents.data(), (std::streamsize)contents.size()))
+        {
+            std::cerr << "Could not read " << file.path.string() << "\n";
+            return 1;
+        }
+
+        file.entry.checksum = hash_fnv1a64(std::string_view(contents.data(), contents.size()));
+        out.write(contents.data(), (std::streamsize)contents.size());
+        offset += contents.size();
+    }
+
+    std::vector<PackEntry> entries;
+    entries.reserve(files.size());
+    for (const auto& file : files)
+        entries.push_back(file.entry);
+
+    std::sort(entries.begin(), entries.end(), [](const PackEntry& a, const PackEntry& b) { return a.name_hash < b.name_hash; });
+
+    out.seekp((std::streamoff)header.toc_offset);
+    out.write((const char*)entries.data(), (std::streamsize)(entries.size() * sizeof(PackEntry)));
+    out.close();
+
+    if (!out)
+    {
+        std::cerr << "Could not write " << temp_path.string() << "\n";
+        return 1;
+    }
+
+    std::filesystem::rename(temp_path, output);
+
+    std::cout << "Packed " << files.size() << " files (" << offset / 1024 << " KB) into " << output.string() << "\n";
+    return 0;
+}